@@ -0,0 +1,320 @@
+/*
+	Benchmarks of the parser,uniform lookup and setter hot paths,without a GL context
+	(every gl* entry point is a no-op from jglsl_gl_stub.h).
+
+	Build & run :
+		g++ -O2 -std=c++11 jglsl_bench.cpp -o jglsl_bench
+		./jglsl_bench [filter]		//Only benchmarks whose name contains filter
+		./jglsl_bench parse			//parse/ against parse_legacy/ (the strstr parser before the scanner)
+		./jglsl_bench scan			//scan/ : scanner alone,without the serialization parse/ includes
+		./jglsl_bench types			//Builtin type classification per token,table against the old linear search
+
+	Output : one JSON object per line,ie
+		{"bench":"parse/large","ops":512,"ns_per_op":183321.40,"mb_per_s":151.22}
+	Compare the ns_per_op of two runs to catch regressions.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#include "jglsl_gl_stub.h"
+#include "../jglsl_shader.hpp"
+#include "jglsl_legacy_parser.h"
+
+#include <chrono>
+
+static const char* g_filter = 0;
+static volatile uint64_t g_sink = 0;	//Keeps measured results alive
+
+//Runs fn(i) for a calibrated number of ops (at least ~100ms),best of 3 runs
+template <typename fn_t>
+static void bench(const std::string& name,const uint64_t bytes_per_op,fn_t fn) {
+	if (g_filter && (name.find(g_filter) == std::string::npos))
+		return;
+
+	typedef std::chrono::steady_clock steady_t;
+	uint64_t ops = 1;
+	double best = 0.0;
+	for (;;) {
+		const steady_t::time_point start = steady_t::now();
+		for (uint64_t i = 0;i < ops;++i)
+			fn(i);
+		best = std::chrono::duration<double>(steady_t::now() - start).count();
+		if (best >= 0.1)
+			break;
+		ops *= 2;
+	}
+
+	for (uint32_t run = 0;run < 2;++run) {
+		const steady_t::time_point start = steady_t::now();
+		for (uint64_t i = 0;i < ops;++i)
+			fn(i);
+		best = std::min(best,std::chrono::duration<double>(steady_t::now() - start).count());
+	}
+
+	printf("{\"bench\":\"%s\",\"ops\":%llu,\"ns_per_op\":%.2f",name.c_str(),(unsigned long long)ops,(best * 1e9) / ops);
+	if (bytes_per_op != 0)
+		printf(",\"mb_per_s\":%.2f",((double)bytes_per_op * ops) / (best * 1e6));
+	printf("}\n");
+	fflush(stdout);
+}
+
+/*Corpus*/
+static const char* g_small =
+	"#version 330 core\n"
+	"uniform mat4 u_mvp;\n"
+	"uniform vec4 u_color;\n"
+	"in vec3 a_position;\n"
+	"in vec2 a_uv;\n"
+	"out vec2 v_uv;\n"
+	"void main() {\n"
+	"	v_uv = a_uv;\n"
+	"	gl_Position = u_mvp * vec4(a_position,1.0);\n"
+	"}\n";
+
+static const char* g_struct_heavy =
+	"#version 330 core\n"
+	"#define MAX_LIGHTS 8\n"
+	"const int N = 4;\n"
+	"struct attenuation_t { float constant; float linear; float quadratic; };\n"
+	"struct light_t { vec3 position; vec3 color; attenuation_t att; float range; int type; };\n"
+	"struct material_t { vec4 albedo; float roughness; float metallic; sampler2D maps[N]; };\n"
+	"struct cascade_t { mat4 view_proj; vec2 depth_range; };\n"
+	"struct shadow_t { cascade_t cascades[N]; float bias; sampler2D atlas; };\n"
+	"struct scene_t { light_t lights[MAX_LIGHTS]; shadow_t shadow; vec3 ambient; int light_count; };\n"
+	"uniform scene_t u_scene;\n"
+	"uniform material_t u_materials[N];\n"
+	"uniform light_t u_sun;\n"
+	"layout(std140) uniform Camera { mat4 view; mat4 proj; vec4 eye; light_t key_light; };\n"
+	"in vec3 v_normal;\n"
+	"out vec4 o_color;\n"
+	"void main() {\n"
+	"	vec3 c = u_scene.ambient;\n"
+	"	for (int i = 0;i < u_scene.light_count;++i) c += u_scene.lights[i].color;\n"
+	"	o_color = vec4(c,1.0) * u_materials[0].albedo;\n"
+	"}\n";
+
+static const char* g_comment_heavy =
+	"#version 330 core\n"
+	"/*\n"
+	"	Forward pass.\n"
+	"	uniform mat4 u_not_a_uniform; (inside a comment)\n"
+	"*/\n"
+	"// uniform vec4 u_commented_out;\n"
+	"uniform /* inline */ mat4 u_model; // Model matrix\n"
+	"uniform mat4 /* view */ u_view; /* trailing */\n"
+	"// ------------------------------------------------------------------------------\n"
+	"// Lighting\n"
+	"// ------------------------------------------------------------------------------\n"
+	"/** Direction towards the light,normalized. */\n"
+	"uniform vec3 u_light_dir;\n"
+	"/* struct unused_t { float x; }; */\n"
+	"uniform float u_exposure; /* ev */ uniform float u_gamma; // 2.2\n"
+	"in vec3 a_position; // object space\n"
+	"in vec3 a_normal; /* object space,not normalized */\n"
+	"void main() {\n"
+	"	// Transform\n"
+	"	gl_Position = u_view * u_model * vec4(a_position,1.0); /* clip */\n"
+	"}\n";
+
+//Uber shader style source : count uniforms and structs,plus function bodies the scanner has to skip
+static std::string make_large(const uint32_t count) {
+	std::string code = "#version 430 core\n";
+	char line[256];
+	for (uint32_t i = 0;i < count / 8;++i) {
+		sprintf(line,"struct s%u_t { vec4 a; mat3 b; float c[4]; };\nuniform s%u_t u_s%u;\n",i,i,i);
+		code += line;
+	}
+
+	static const char* types[] = { "float","vec2","vec3","vec4","mat4","int","uint","sampler2D" };
+	for (uint32_t i = 0;i < count;++i) {
+		sprintf(line,"uniform %s u_%u;\n",types[i & 7],i);
+		code += line;
+	}
+
+	code += "in vec3 a_position;\nin vec3 a_normal;\nin vec2 a_uv;\n";
+	for (uint32_t i = 0;i < count / 4;++i) {
+		sprintf(line,"vec4 f%u(vec4 x) {\n\tvec4 y = x * %u.0;\n\tif (y.x > 0.5) { y = y.yzwx; }\n\treturn y + vec4(u_3,0.0);\n}\n",i,i);
+		code += line;
+	}
+	code += "void main() { gl_Position = vec4(a_position,1.0); }\n";
+	return code;
+}
+
+//Program with count vec4 uniforms u_0..u_(count - 1)
+static std::string make_uniforms(const uint32_t count) {
+	std::string code = "#version 330 core\n";
+	char line[64];
+	for (uint32_t i = 0;i < count;++i) {
+		sprintf(line,"uniform vec4 u_%u;\n",i);
+		code += line;
+	}
+	code += "void main() { gl_Position = u_0; }\n";
+	return code;
+}
+
+static void bench_parse(const char* name,const std::string& code) {
+	jglsl_shader_c shader;
+	const char* src = code.c_str();
+	const uint32_t len = code.length();
+	const GLenum type = GL_VERTEX_SHADER;
+	std::vector<uint8_t> out;
+
+	bench(std::string("parse/") + name,len,[&](uint64_t) {
+		out.clear();
+		shader.reflect_sources(&src,&len,1,out,&type);
+		g_sink += out.size();
+	});
+}
+
+//Scanner alone (no serialization),the work parse_legacy/ measures
+static void bench_scan(const char* name,const std::string& code) {
+	jglsl_shader_c shader;
+	jglsl_scan_result_t res;
+
+	bench(std::string("scan/") + name,code.length(),[&](uint64_t) {
+		res.clear();
+		shader.reflect_source(res,GL_VERTEX_SHADER,code.c_str(),code.length());
+		g_sink += res.uniforms.size() + res.attributes.size();
+	});
+}
+
+//Same sources through the parser load() used before the single pass scanner (comment free sources only)
+static void bench_parse_legacy(const char* name,const std::string& code) {
+	const jglsl_legacy_parser_t parser;
+	std::vector<std::string> uniforms,uniform_types,attributes,attribute_types;
+
+	bench(std::string("parse_legacy/") + name,code.length(),[&](uint64_t) {
+		uniforms.clear();
+		uniform_types.clear();
+		attributes.clear();
+		attribute_types.clear();
+		parser.parse(code.c_str(),code.length(),uniforms,uniform_types,attributes,attribute_types);
+		g_sink += uniforms.size() + attributes.size();
+	});
+}
+
+//Type token classification,jglsl_builtin_types_t against the linear search of the old parser
+static void bench_types(const uint32_t extra) {
+	static const char* tokens[16] = {
+		"float","vec3","mat4","sampler2D","int","ivec4","usampler3D","light_t",
+		"main","uint","return","dmat4x3","x","bool","image2D","material_t"
+	};
+
+	jglsl_builtin_types_t table;
+	jglsl_legacy_parser_t legacy;
+	const char* std_exact[] = { "int","uint","bool","float","double","atomic_uint" };
+	const char* std_complex[] = { "vec","mat","image","sampler" };
+	for (uint32_t i = 0;i < 6;++i)
+		table.add(std_exact[i],false);
+	for (uint32_t i = 0;i < 4;++i)
+		table.add(std_complex[i],true);
+
+	char tmp[32];
+	for (uint32_t i = 0;i < extra;++i) {
+		sprintf(tmp,"t%u_t",i);
+		table.add(tmp,false);
+		legacy.base_types.push_back(tmp);
+	}
+
+	std::vector<std::string> strs(tokens,tokens + 16);
+	std::vector<jglsl_span_t> spans(16);
+	for (uint32_t i = 0;i < 16;++i) {
+		spans[i].ptr = strs[i].c_str();
+		spans[i].len = strs[i].length();
+	}
+
+	sprintf(tmp,"/extra%u",extra);
+	const std::string suffix = tmp;
+
+	bench("types/table" + suffix,0,[&](uint64_t i) {
+		g_sink += table.match(spans[i & 15]);
+	});
+
+	bench("types/legacy" + suffix,0,[&](uint64_t i) {
+		g_sink += jglsl_legacy_parser_t::is_builtin_type(strs[i & 15],legacy.base_types,legacy.complex_types);
+	});
+}
+
+static void bench_lookups(const uint32_t count) {
+	jglsl_shader_c shader;
+	shader.load(GL_VERTEX_SHADER,make_uniforms(count));
+	shader.finalize();
+
+	std::vector<std::string> names(count);
+	std::vector<uint32_t> locations(count);
+	char tmp[32];
+	for (uint32_t i = 0;i < count;++i) {
+		sprintf(tmp,"u_%u",i);
+		names[i] = tmp;
+		locations[i] = shader.get_uniform(names[i]);
+	}
+	const jglsl_uniform_handle_t handle = shader.get_uniform_handle(names[count / 2]);
+
+	sprintf(tmp,"/%u",count);
+	const std::string suffix = tmp;
+	const uint32_t mask = count - 1;
+
+	bench("lookup/string" + suffix,0,[&](uint64_t i) {
+		g_sink += shader.get_uniform(names[i & mask]);
+	});
+
+	bench("lookup/literal" + suffix,0,[&](uint64_t) {
+		g_sink += shader.get_uniform("u_0");		//Hash computed at compile time
+	});
+
+	bench("lookup/miss" + suffix,0,[&](uint64_t) {
+		g_sink += shader.get_uniform("u_missing");
+	});
+
+	bench("lookup/handle" + suffix,0,[&](uint64_t) {
+		g_sink += shader.get_uniform(handle);
+	});
+
+	//Setters,values change every call (GL call issued) or never (dropped by the shadow state)
+	float v[4] = { 0.0f,1.0f,2.0f,3.0f };
+	shader.bind();
+
+	bench("set/name_changed" + suffix,0,[&](uint64_t i) {
+		v[0] = (float)i;
+		shader.u_4fv(jglsl_uniform_key_t(names[i & mask]),v);
+	});
+
+	bench("set/index_changed" + suffix,0,[&](uint64_t i) {
+		v[0] = (float)i;
+		shader.u_4fv(locations[i & mask],v);
+	});
+
+	bench("set/name_same" + suffix,0,[&](uint64_t i) {
+		shader.u_4fv(jglsl_uniform_key_t(names[i & mask]),v);
+	});
+
+	bench("set/index_same" + suffix,0,[&](uint64_t i) {
+		shader.u_4fv(locations[i & mask],v);
+	});
+
+	shader.unbind();
+}
+
+int main(int argc,char** argv) {
+	if (argc > 1)
+		g_filter = argv[1];
+
+	bench_parse("small",g_small);
+	bench_parse("struct_heavy",g_struct_heavy);
+	bench_parse("comment_heavy",g_comment_heavy);
+	bench_parse("large",make_large(512));
+	bench_scan("small",g_small);
+	bench_scan("large",make_large(512));
+	bench_parse_legacy("small",g_small);
+	bench_parse_legacy("large",make_large(512));
+
+	bench_types(0);
+	bench_types(40);
+
+	//Power of two sizes (names are picked with a mask)
+	bench_lookups(8);
+	bench_lookups(64);
+	bench_lookups(512);
+	return 0;
+}
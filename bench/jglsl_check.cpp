@@ -0,0 +1,184 @@
+/*
+	Reflection,preprocessor and uniform staging checks without a GL context (every gl* entry point
+	comes from jglsl_gl_stub.h,uniform updates are recorded instead of sent).
+
+	Build & run :
+		g++ -O2 -std=c++11 jglsl_check.cpp -o jglsl_check
+		./jglsl_check				//Prints every failed check,exit code 1 if any
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#include "jglsl_gl_stub.h"
+#include "../jglsl_shader.hpp"
+
+static uint32_t g_checks = 0;
+static uint32_t g_failures = 0;
+
+#define JGLSL_CHECK(_cond_) check((_cond_),#_cond_,__LINE__)
+
+static void check(const bool ok,const char* what,const uint32_t line) {
+	++g_checks;
+	if (!ok) {
+		printf("FAIL line %u : %s\n",line,what);
+		++g_failures;
+	}
+}
+
+static bool build(jglsl_shader_c& shader,const char* vs,const jglsl_define_set_t& defines = jglsl_define_set_t::none()) {
+	static const char* fs = "#version 330 core\nout vec4 o_color;\nvoid main() { o_color = vec4(1.0); }\n";
+	return shader.load(GL_VERTEX_SHADER,vs,strlen(vs),defines) && shader.load(GL_FRAGMENT_SHADER,fs,strlen(fs)) && shader.finalize();
+}
+
+static uint32_t member_offset(const jglsl_uniform_block_t* b,const char* member) {
+	const jglsl_block_member_t* m = b ? b->find_member(member) : 0;
+	return m ? m->offset : jglsl_invalid_offset;
+}
+
+static void check_std140() {
+	static const char* vs =
+		"#version 330 core\n"
+		"layout(std140) uniform Frame {\n"
+		"	mat4 view_proj;\n"
+		"	vec3 eye;\n"
+		"	float time;\n"
+		"	vec2 jitter;\n"
+		"	float weights[3];\n"
+		"	ivec4 flags;\n"
+		"	vec3 sun;\n"
+		"};\n"
+		"void main() { gl_Position = view_proj * vec4(eye,time); }\n";
+
+	jglsl_shader_c shader;
+	JGLSL_CHECK(build(shader,vs));
+
+	const jglsl_uniform_block_t* b = shader.find_block("Frame");
+	JGLSL_CHECK(b && (b->layout == JGLSL_LAYOUT_STD140) && (b->size == 176));
+	JGLSL_CHECK(member_offset(b,"view_proj") == 0);
+	JGLSL_CHECK(member_offset(b,"eye") == 64);
+	JGLSL_CHECK(member_offset(b,"time") == 76);		//Packed after the vec3
+	JGLSL_CHECK(member_offset(b,"jitter") == 80);
+	JGLSL_CHECK(member_offset(b,"weights") == 96);	//Array elements are vec4 aligned
+	JGLSL_CHECK(b && b->find_member("weights") && (b->find_member("weights")->array_stride == 16));
+	JGLSL_CHECK(member_offset(b,"flags") == 144);
+	JGLSL_CHECK(member_offset(b,"sun") == 160);
+}
+
+static void check_std430() {
+	static const char* vs =
+		"#version 430 core\n"
+		"struct draw_t { mat4 model; vec4 color; vec2 uv; };\n"
+		"layout(std430,binding = 2) buffer Draws {\n"
+		"	uint count;\n"
+		"	draw_t draws[];\n"
+		"};\n"
+		"void main() { gl_Position = draws[0].model * draws[0].color; }\n";
+
+	jglsl_shader_c shader;
+	JGLSL_CHECK(build(shader,vs));
+
+	jglsl_draw_layout_t layout;
+	JGLSL_CHECK(shader.get_draw_layout("Draws",layout));
+	JGLSL_CHECK((layout.offset == 16) && (layout.stride == 96));	//Struct size rounded up to its vec4 alignment
+	JGLSL_CHECK(layout.find_field("color") && (layout.find_field("color")->offset == 64));
+	JGLSL_CHECK(layout.find_field("uv") && (layout.find_field("uv")->offset == 80));
+}
+
+static void check_preprocessor() {
+	static const char* vs =
+		"#version 330 core\n"
+		"#define USE_B 1\n"
+		"#if defined(USE_A)\n"
+		"uniform float u_a;\n"
+		"#elif USE_B && !defined(USE_C)\n"
+		"uniform float u_b;\n"
+		"#else\n"
+		"uniform float u_c;\n"
+		"#endif\n"
+		"#ifndef USE_A\n"
+		"uniform float u_not_a;\n"
+		"#endif\n"
+		"void main() { gl_Position = vec4(0.0); }\n";
+
+	jglsl_shader_c b;
+	JGLSL_CHECK(build(b,vs));
+	JGLSL_CHECK((b.get_uniform("u_a") == 0) && (b.get_uniform("u_b") != 0) && (b.get_uniform("u_c") == 0));
+	JGLSL_CHECK(b.get_uniform("u_not_a") != 0);
+
+	jglsl_shader_c a;
+	JGLSL_CHECK(build(a,vs,jglsl_define_set_t().add("USE_A")));
+	JGLSL_CHECK((a.get_uniform("u_a") != 0) && (a.get_uniform("u_b") == 0) && (a.get_uniform("u_not_a") == 0));
+
+	jglsl_shader_c c;
+	JGLSL_CHECK(build(c,vs,jglsl_define_set_t().add("USE_C")));
+	JGLSL_CHECK((c.get_uniform("u_b") == 0) && (c.get_uniform("u_c") != 0));
+}
+
+//Batched uniform values are never dropped : each staged element reaches GL exactly once
+static void check_staging() {
+	static const char* vs = "#version 330 core\nuniform float u_w[8];\nvoid main() { gl_Position = vec4(u_w[0]); }\n";
+	const float v[8] = { 1,2,3,4,5,6,7,8 };
+	const float big[9] = { 9,9,9,9,9,9,9,9,9 };
+
+	jglsl_shader_c shader,other;
+	JGLSL_CHECK(build(shader,vs) && build(other,vs));
+	const uint32_t w = shader.get_uniform("u_w");
+	std::vector<jglsl_stub_upload_t>& up = jglsl_stub_uploads;
+	jglsl_stub_record = true;
+
+	//Write past the valid elements : the staged ones go out first,the gap is never sent
+	shader.bind();
+	shader.set_batched(true);
+	up.clear();
+	shader.u_fv(w,2,v);
+	shader.u_fv(w + 5,1,v + 5);
+	JGLSL_CHECK((up.size() == 1) && (up[0].location == (GLint)w) && (up[0].count == 2));
+	shader.flush();
+	JGLSL_CHECK((up.size() == 2) && (up[1].location == (GLint)(w + 5)) && (up[1].count == 1) && (up[1].first == 6.0));
+
+	//Staged elements next to known ones are merged into one call
+	up.clear();
+	shader.u_fv(w + 1,1,v + 3);
+	shader.u_fv(w,1,v + 7);
+	JGLSL_CHECK(up.empty());
+	shader.flush();
+	JGLSL_CHECK((up.size() == 1) && (up[0].location == (GLint)w) && (up[0].count == 2) && (up[0].first == 8.0));
+
+	//A write larger than the shadow copy resets it,staged elements are sent before
+	up.clear();
+	shader.u_fv(w,1,v + 2);
+	shader.u_fv(w,9,big);
+	JGLSL_CHECK((up.size() == 2) && (up[0].count == 1) && (up[0].first == 3.0) && (up[1].count == 9));
+	shader.flush();
+	JGLSL_CHECK(up.size() == 2);
+
+	//invalidate_uniform_cache() keeps staged values
+	up.clear();
+	shader.u_fv(w,2,v + 4);
+	shader.invalidate_uniform_cache();
+	shader.flush();
+	JGLSL_CHECK((up.size() == 1) && (up[0].count == 2) && (up[0].first == 5.0));
+
+	//Writes that cannot be staged reach this program,not the one in use
+	other.bind();
+	up.clear();
+	shader.u_fv(w,2,v);
+	shader.u_fv(w,9,big);
+	JGLSL_CHECK((up.size() == 2) && (up[0].program == shader.get_program()) && (up[1].program == shader.get_program()));
+	JGLSL_CHECK(jglsl_stub_program == other.get_program());
+
+	shader.set_batched(false);
+	jglsl_stub_record = false;
+	up.clear();
+}
+
+int main() {
+	check_std140();
+	check_std430();
+	check_preprocessor();
+	check_staging();
+
+	printf("%u checks,%u failed\n",g_checks,g_failures);
+	return (g_failures == 0) ? 0 : 1;
+}
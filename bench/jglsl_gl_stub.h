@@ -0,0 +1,226 @@
+/*
+	No-op OpenGL entry points for jglsl_bench.cpp and jglsl_check.cpp : enough of GL 3.3 to load,finalize
+	and drive jglsl_shader_c without a context.Compiles and links always succeed,every uniform/attribute
+	name gets its own location ("name[k]" : location of name + k).
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_gl_stub_h_
+#define _jglsl_gl_stub_h_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <map>
+#include <string>
+#include <vector>
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef float GLfloat;
+typedef double GLdouble;
+typedef char GLchar;
+typedef unsigned char GLubyte;
+typedef unsigned char GLboolean;
+typedef ptrdiff_t GLintptr;
+typedef ptrdiff_t GLsizeiptr;
+typedef unsigned int GLbitfield;
+typedef uint64_t GLuint64;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#define GL_VENDOR 0x1F00
+#define GL_RENDERER 0x1F01
+#define GL_VERSION 0x1F02
+#define GL_EXTENSIONS 0x1F03
+#define GL_NUM_EXTENSIONS 0x821D
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_GEOMETRY_SHADER 0x8DD9
+#define GL_TESS_CONTROL_SHADER 0x8E88
+#define GL_TESS_EVALUATION_SHADER 0x8E87
+#define GL_COMPUTE_SHADER 0x91B9
+#define GL_VERTEX_SHADER_BIT 0x00000001
+#define GL_FRAGMENT_SHADER_BIT 0x00000002
+#define GL_GEOMETRY_SHADER_BIT 0x00000004
+#define GL_TESS_CONTROL_SHADER_BIT 0x00000008
+#define GL_TESS_EVALUATION_SHADER_BIT 0x00000010
+#define GL_COMPUTE_SHADER_BIT 0x00000020
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+#define GL_INFO_LOG_LENGTH 0x8B84
+#define GL_ACTIVE_UNIFORMS 0x8B86
+#define GL_PROGRAM_SEPARABLE 0x8258
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_COMPUTE_WORK_GROUP_SIZE 0x8267
+#define GL_UNIFORM_BLOCK_DATA_SIZE 0x8A40
+#define GL_UNIFORM_OFFSET 0x8A3B
+#define GL_UNIFORM_ARRAY_STRIDE 0x8A3C
+#define GL_UNIFORM_MATRIX_STRIDE 0x8A3D
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#define GL_DISPATCH_INDIRECT_BUFFER 0x90EE
+#define GL_TIME_ELAPSED 0x88BF
+#define GL_QUERY_RESULT 0x8866
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#define GL_INT 0x1404
+#define GL_UNSIGNED_INT 0x1405
+#define GL_FLOAT 0x1406
+#define GL_DOUBLE 0x140A
+#define GL_FLOAT_VEC2 0x8B50
+#define GL_FLOAT_VEC3 0x8B51
+#define GL_FLOAT_VEC4 0x8B52
+#define GL_INT_VEC2 0x8B53
+#define GL_INT_VEC3 0x8B54
+#define GL_INT_VEC4 0x8B55
+#define GL_BOOL 0x8B56
+#define GL_BOOL_VEC2 0x8B57
+#define GL_BOOL_VEC3 0x8B58
+#define GL_BOOL_VEC4 0x8B59
+#define GL_FLOAT_MAT2 0x8B5A
+#define GL_FLOAT_MAT3 0x8B5B
+#define GL_FLOAT_MAT4 0x8B5C
+#define GL_UNSIGNED_INT_VEC2 0x8DC6
+#define GL_UNSIGNED_INT_VEC3 0x8DC7
+#define GL_UNSIGNED_INT_VEC4 0x8DC8
+#define GL_DOUBLE_VEC2 0x8FFC
+#define GL_DOUBLE_VEC3 0x8FFD
+#define GL_DOUBLE_VEC4 0x8FFE
+#define GL_DOUBLE_MAT2 0x8F46
+#define GL_DOUBLE_MAT3 0x8F47
+#define GL_DOUBLE_MAT4 0x8F48
+#define GL_FLOAT_MAT2x3 0x8B65
+#define GL_FLOAT_MAT2x4 0x8B66
+#define GL_FLOAT_MAT3x2 0x8B67
+#define GL_FLOAT_MAT3x4 0x8B68
+#define GL_FLOAT_MAT4x2 0x8B69
+#define GL_FLOAT_MAT4x3 0x8B6A
+#define GL_DOUBLE_MAT2x3 0x8F49
+#define GL_DOUBLE_MAT2x4 0x8F4A
+#define GL_DOUBLE_MAT3x2 0x8F4B
+#define GL_DOUBLE_MAT3x4 0x8F4C
+#define GL_DOUBLE_MAT4x2 0x8F4D
+#define GL_DOUBLE_MAT4x3 0x8F4E
+#define GL_TEXTURE0 0x84C0
+#define GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS 0x8B4D
+
+//GL calls that would reach the driver (issued uniform updates included)
+static uint64_t jglsl_stub_calls = 0;
+static GLuint jglsl_stub_program = 0;	//glUseProgram
+
+//Uniform updates,only recorded while jglsl_stub_record is set
+struct jglsl_stub_upload_t {
+	GLuint program;		//Target of glProgramUniform*,the program in use for glUniform*
+	GLint location;
+	GLsizei count;
+	double first;		//First value sent
+};
+static bool jglsl_stub_record = false;
+static std::vector<jglsl_stub_upload_t> jglsl_stub_uploads;
+
+template <typename type_t>
+inline void jglsl_stub_upload(const GLuint program,const GLint location,const GLsizei count,const type_t* data) {
+	++jglsl_stub_calls;
+	if (jglsl_stub_record) {
+		const jglsl_stub_upload_t u = { program,location,count,(double)data[0] };
+		jglsl_stub_uploads.push_back(u);
+	}
+}
+
+inline std::map<std::string,GLint>& jglsl_stub_locations() {
+	static std::map<std::string,GLint> locations;
+	return locations;
+}
+
+inline GLint jglsl_stub_location(const GLchar* name) {
+	const char* element = strrchr(name,'[');
+	if ((element != 0) && (element != name))
+		return jglsl_stub_location(std::string(name,element - name).c_str()) + (GLint)strtoul(element + 1,0,10);
+
+	std::map<std::string,GLint>& locations = jglsl_stub_locations();
+	std::map<std::string,GLint>::iterator it = locations.find(name);
+	if (it != locations.end())
+		return it->second;
+
+	const GLint loc = (GLint)(locations.size() + 1) * 16;	//Room for small arrays,0 stays unused (get_uniform() misses)
+	locations.insert(std::make_pair(std::string(name),loc));
+	return loc;
+}
+
+inline const GLubyte* glGetString(const GLenum e) {
+	return (const GLubyte*)((e == GL_VERSION) ? "3.3 jglsl bench stub" : (e == GL_EXTENSIONS) ? "" : "jglsl");
+}
+
+inline const GLubyte* glGetStringi(GLenum,GLuint) { return (const GLubyte*)""; }
+inline void glGetIntegerv(GLenum,GLint* v) { *v = 0; }
+
+inline GLuint glCreateShader(GLenum) { static GLuint n = 1; return n++; }
+inline void glShaderSource(GLuint,GLsizei,const GLchar* const*,const GLint*) { ++jglsl_stub_calls; }
+inline void glCompileShader(GLuint) { ++jglsl_stub_calls; }
+inline void glGetShaderiv(GLuint,const GLenum e,GLint* v) { *v = (e == GL_INFO_LOG_LENGTH) ? 1 : GL_TRUE; }
+inline void glGetShaderInfoLog(GLuint,GLsizei n,GLsizei* l,GLchar* s) { if (n) s[0] = 0; if (l) *l = 0; }
+inline void glDeleteShader(GLuint) {}
+
+inline GLuint glCreateProgram() { static GLuint n = 1; return n++; }
+inline void glDeleteProgram(GLuint) {}
+inline void glAttachShader(GLuint,GLuint) {}
+inline void glLinkProgram(GLuint) { ++jglsl_stub_calls; }
+inline void glProgramParameteri(GLuint,GLenum,GLint) {}
+inline void glGetProgramiv(GLuint,const GLenum e,GLint* v) { *v = (e == GL_INFO_LOG_LENGTH) ? 1 : (e == GL_ACTIVE_UNIFORMS) ? 0 : GL_TRUE; }
+inline void glGetProgramInfoLog(GLuint,GLsizei n,GLsizei* l,GLchar* s) { if (n) s[0] = 0; if (l) *l = 0; }
+inline void glGetProgramBinary(GLuint,GLsizei,GLsizei* l,GLenum*,void*) { *l = 0; }
+inline void glProgramBinary(GLuint,GLenum,const void*,GLsizei) {}
+inline void glUseProgram(const GLuint program) { ++jglsl_stub_calls; jglsl_stub_program = program; }
+inline void glUseProgramStages(GLuint,GLbitfield,GLuint) {}
+inline void glMaxShaderCompilerThreadsKHR(GLuint) {}
+
+inline GLint glGetUniformLocation(GLuint,const GLchar* name) { return jglsl_stub_location(name); }
+inline GLint glGetAttribLocation(GLuint,const GLchar* name) { return jglsl_stub_location(name); }
+inline void glGetActiveUniform(GLuint,GLuint,GLsizei,GLsizei* l,GLint* size,GLenum* type,GLchar* name) { name[0] = 0; *l = 0; *size = 1; *type = 0; }
+
+inline GLuint glGetUniformBlockIndex(GLuint,const GLchar*) { return 0; }
+inline void glUniformBlockBinding(GLuint,GLuint,GLuint) {}
+inline void glGetActiveUniformBlockiv(GLuint,GLuint,GLenum,GLint* v) { *v = 0; }
+inline void glGetUniformIndices(GLuint,GLsizei n,const GLchar* const*,GLuint* idx) { for (GLsizei i = 0;i < n;++i) idx[i] = i; }
+inline void glGetActiveUniformsiv(GLuint,GLsizei n,const GLuint*,GLenum,GLint* v) { for (GLsizei i = 0;i < n;++i) v[i] = 0; }
+
+inline void glShaderStorageBlockBinding(GLuint,GLuint,GLuint) {}
+inline void glBindBuffer(GLenum,GLuint) {}
+inline void glBindBufferBase(GLenum,GLuint,GLuint) {}
+inline void glBindBufferRange(GLenum,GLuint,GLuint,GLintptr,GLsizeiptr) {}
+inline void glBufferSubData(GLenum,GLintptr,GLsizeiptr,const void*) {}
+inline void glActiveTexture(GLenum) {}
+inline void glBindTexture(GLenum,GLuint) {}
+inline void glDispatchCompute(GLuint,GLuint,GLuint) {}
+inline void glDispatchComputeIndirect(GLintptr) {}
+inline void glMemoryBarrier(GLbitfield) {}
+
+inline void glGenQueries(GLsizei n,GLuint* q) { static GLuint c = 1; for (GLsizei i = 0;i < n;++i) q[i] = c++; }
+inline void glDeleteQueries(GLsizei,const GLuint*) {}
+inline void glBeginQuery(GLenum,GLuint) {}
+inline void glEndQuery(GLenum) {}
+inline void glGetQueryObjectiv(GLuint,GLenum,GLint* v) { *v = GL_TRUE; }
+inline void glGetQueryObjectui64v(GLuint,GLenum,GLuint64* v) { *v = 0; }
+
+#define JGLSL_STUB_UNIFORM_V(_suffix_,_type_) \
+	inline void glUniform##_suffix_(GLint l,GLsizei n,const _type_* v) { jglsl_stub_upload(jglsl_stub_program,l,n,v); } \
+	inline void glProgramUniform##_suffix_(GLuint p,GLint l,GLsizei n,const _type_* v) { jglsl_stub_upload(p,l,n,v); }
+#define JGLSL_STUB_UNIFORM_M(_suffix_,_type_) \
+	inline void glUniformMatrix##_suffix_(GLint l,GLsizei n,GLboolean,const _type_* v) { jglsl_stub_upload(jglsl_stub_program,l,n,v); } \
+	inline void glProgramUniformMatrix##_suffix_(GLuint p,GLint l,GLsizei n,GLboolean,const _type_* v) { jglsl_stub_upload(p,l,n,v); }
+
+JGLSL_STUB_UNIFORM_V(1fv,GLfloat) JGLSL_STUB_UNIFORM_V(2fv,GLfloat) JGLSL_STUB_UNIFORM_V(3fv,GLfloat) JGLSL_STUB_UNIFORM_V(4fv,GLfloat)
+JGLSL_STUB_UNIFORM_V(1dv,GLdouble) JGLSL_STUB_UNIFORM_V(2dv,GLdouble) JGLSL_STUB_UNIFORM_V(3dv,GLdouble) JGLSL_STUB_UNIFORM_V(4dv,GLdouble)
+JGLSL_STUB_UNIFORM_V(1iv,GLint) JGLSL_STUB_UNIFORM_V(1uiv,GLuint)
+JGLSL_STUB_UNIFORM_M(3fv,GLfloat) JGLSL_STUB_UNIFORM_M(4fv,GLfloat) JGLSL_STUB_UNIFORM_M(3dv,GLdouble) JGLSL_STUB_UNIFORM_M(4dv,GLdouble)
+
+#undef JGLSL_STUB_UNIFORM_M
+#undef JGLSL_STUB_UNIFORM_V
+
+#endif
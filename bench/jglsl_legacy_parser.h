@@ -0,0 +1,286 @@
+/*
+	The strstr based parser load() used before the single pass scanner,bugs included (line comments
+	swallow the rest of the source,block comments end at the first '*' or '/').
+	Only kept as the baseline of the parse_legacy/ benchmarks,feed it sources without comments.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_legacy_parser_h_
+#define _jglsl_legacy_parser_h_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <ctype.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+struct jglsl_legacy_parser_t {
+	std::vector<std::string> base_types;
+	std::vector<std::string> complex_types;
+
+	jglsl_legacy_parser_t() {
+		static const char* base[] = { "int","uint","bool","float","double","atomic_uint" };
+		static const char* complex[] = { "vec","mat","image","sampler" };
+		base_types.assign(base,base + 6);
+		complex_types.assign(complex,complex + 4);
+	}
+
+	//What load() collected per source : uniforms and attributes with their builtin types
+	void parse(const char* code,const uint32_t len,std::vector<std::string>& uniforms,std::vector<std::string>& uniform_types,
+				std::vector<std::string>& attributes,std::vector<std::string>& attribute_types) const {
+		parse_vars(uniforms,uniform_types,"uniform",code,len,base_types,complex_types);
+		parse_vars(attributes,attribute_types,"attribute",code,len,base_types,complex_types);
+	}
+
+	static uint32_t skip_ws(const char* code,const uint32_t offs,const uint32_t len) {
+		uint32_t ptr = offs;
+		bool done = false;
+
+		while ( (!done) && (ptr < len) ) {
+			done = true;
+
+			//Whitespace first
+			while ((ptr < len) && isspace(code[ptr]))
+				++ptr;
+
+			//Skip comments
+			if (((ptr+1) < len) && (code[ptr] == '/')) {
+				if ((code[ptr+1] == '/')) {
+					++ptr;
+					while ((ptr < len) && ((code[ptr] != '\n') || (code[ptr] != '\r')))
+						++ptr;
+				} else if ((code[ptr+1] == '*')) { 
+					ptr += 2;
+					while ((ptr+1 < len) && ( (code[ptr] != '*') && (code[ptr+1] != '/')))
+						++ptr;
+					if ((ptr+1 < len) && ( (code[ptr] == '*') && (code[ptr+1] == '/')))
+						ptr += 2;
+				}
+
+				done = false;
+			}
+ 		}
+
+		return ptr;
+	}
+
+	static uint32_t next_tok(std::string& tok,const char* code,const uint32_t offs,const uint32_t len) {
+		uint32_t ptr = offs;
+		tok.clear();
+
+		while ((ptr < len) && (!isspace(code[ptr])) && (code[ptr] != ';') && (code[ptr] != '{') && (code[ptr] != '}')
+			 && (code[ptr] != ',')  && (code[ptr] != '/') && (code[ptr] != '[') )
+			tok += code[ptr++];
+
+		return ptr;
+	}
+
+	static bool is_builtin_type(const std::string& s,
+					const std::vector<std::string>& base_types,
+					const std::vector<std::string>& complex_types) {
+		for (uint32_t i = 0,j = base_types.size();i < j;++i) {
+			if (s == base_types[i])
+				return true;
+		}
+
+		for (uint32_t i = 0,j = complex_types.size();i < j;++i) {
+			if (s.find(complex_types[i]) != std::string::npos)
+				return true;
+		}
+
+		return false;
+	}
+	
+	static std::vector<std::string>* get_struct_field(const std::string& name,std::map<std::string,std::vector<std::string> >& structs) {
+		std::map<std::string,std::vector<std::string> >::iterator it = structs.find(name);
+		return (it != structs.end()) ? &it->second : 0;
+	}
+
+	//Fill up structure list and also handle structure->structure access
+	//struct_types mirrors structs and holds the builtin type of every flattened field
+	static void parse_structures(std::map<std::string,std::vector<std::string> >& structs,
+					std::map<std::string,std::vector<std::string> >& struct_types,const char* code,const uint32_t len,
+					const std::vector<std::string>& base_types,
+					const std::vector<std::string>& complex_types) {
+		const char* pcode = code;
+		std::string tok;
+		std::string cur_type;
+
+		for (uint32_t offs = 0;offs < len;) {
+	 
+			std::string field_name;
+			std::vector<std::string> field_fields;
+			std::vector<std::string> field_types;
+
+			pcode = strstr(pcode,"struct");
+			if (0==pcode)
+				break;
+ 
+			offs = skip_ws(code, (ptrdiff_t)(pcode - code) + 6,len);
+			if (offs>=len)
+				return;
+
+			offs = next_tok(field_name,code,offs,len);
+			if (offs>=len)
+				return;
+			
+			offs = skip_ws(code,offs,len);
+			if (offs>=len)
+				return;
+
+			if (code[offs] != '{') //error
+				return;
+	
+			offs = skip_ws(code,offs + 1,len);
+			if (offs>=len)
+				return;
+
+ 			std::vector<std::string>* struct_fld = 0;
+			while ((offs < len)) {
+				offs = skip_ws(code,offs,len);
+				if (offs>=len)
+					break;
+				if (code[offs] == '}')
+					break;
+		
+				offs = next_tok(tok,code,offs,len);
+				if (is_builtin_type(tok,base_types,complex_types)) {
+					cur_type = tok;
+					offs = skip_ws(code,offs ,len);
+					if (offs >= len)
+						break;
+
+					offs = next_tok(tok,code,offs,len);
+					field_fields.push_back(tok); 
+					field_types.push_back(cur_type);
+				} 
+				else if ((struct_fld = get_struct_field(tok,structs)) != 0) { //Handle struct within struct
+					const std::vector<std::string>* struct_fld_types = get_struct_field(tok,struct_types);
+					cur_type.clear();
+					offs = skip_ws(code,offs ,len);
+					if (offs >= len)
+						break;
+
+					offs = next_tok(tok,code,offs,len);
+					for (uint32_t f = 0,w = struct_fld->size();f < w;++f) {
+						field_fields.push_back(tok + "." + struct_fld->at(f) ); 
+						field_types.push_back(struct_fld_types->at(f));
+						//printf("s->sadd [%s]\n",field_fields.back().c_str());
+					}
+				} else {
+					field_fields.push_back(tok); 
+					field_types.push_back(cur_type);
+					//printf("s->sadd [%s]\n",field_fields.back().c_str());
+				}
+				offs = skip_ws(code,offs ,len);
+				if (offs >= len)
+					break;
+
+				if (code[offs] == ',')
+					++offs;
+				else if (code[offs] == ';')
+					++offs;
+				else if (code[offs] == '[') {
+					++offs;
+					while ((offs < len) && (code[offs] != ']'))
+						++offs;
+					if (offs < len)
+						offs += code[offs] == ']';
+				}
+			}
+
+			if ((offs < len) && (code[offs] == '}')) {
+				structs.insert(std::pair<std::string,std::vector<std::string> >(field_name,field_fields));
+				struct_types.insert(std::pair<std::string,std::vector<std::string> >(field_name,field_types));
+			}
+
+			pcode = &code[offs + 2];
+			if (pcode >= &code[len])
+				return;
+		}
+	}
+
+	//res_types receives the builtin type of every entry pushed to res
+	static void parse_vars(std::vector<std::string>& res,std::vector<std::string>& res_types,const std::string& field_name,const char* code,const uint32_t len,
+					const std::vector<std::string>& base_types,
+					const std::vector<std::string>& complex_types) {
+		const char* pcode = code;
+		std::string tok;
+		const uint32_t field_size = field_name.length();
+ 
+		std::map<std::string,std::vector<std::string> > structs;
+		std::map<std::string,std::vector<std::string> > struct_types;
+		parse_structures(structs,struct_types,code,len,base_types,complex_types);
+ 
+		for (uint32_t offs = 0;offs < len;) {
+			pcode = strstr(pcode,field_name.c_str());
+			if (0==pcode)
+				break;
+ 
+			offs = (ptrdiff_t)(pcode - code );
+ 			pcode += field_size;
+ 
+			uint32_t o = (ptrdiff_t)(pcode - code);
+			uint32_t l = len;
+			
+			//for (;o < l;++o)printf("%c",code[o]); printf("\n");	 
+			std::vector<std::string>* struct_fld = 0;
+			std::vector<std::string>* struct_fld_types = 0;
+
+			o = skip_ws(code,o,l);
+			if (o >= l)
+				break;
+
+			o = next_tok(tok,code,o,l);
+			const std::string type = tok;
+			if (!is_builtin_type(tok,base_types,complex_types)) {			
+				struct_fld = get_struct_field(tok,structs);
+				if (!struct_fld) 
+					continue;
+				struct_fld_types = get_struct_field(tok,struct_types);
+			}
+			//printf("add [%s]\n",tok.c_str());
+			while (o < l) {
+				o = skip_ws(code,o,l);
+				if (o >= l)
+					break;
+				else if (code[o] == ';')
+					break;
+				o = next_tok(tok,code,o,l);
+
+				if (struct_fld)	{
+					for (uint32_t f = 0,w = struct_fld->size();f < w;++f) {
+						res.push_back(tok + "." + struct_fld->at(f) ); 
+						res_types.push_back(struct_fld_types->at(f));
+						//printf("add [%s]\n",res.back().c_str());
+					}
+				}
+				else {
+					res.push_back(tok); 
+					res_types.push_back(type);
+					//printf("add [%s]\n",res.back().c_str());
+				}
+				o = skip_ws(code,o ,l);
+				if (o >= l)
+					break;
+
+				if (code[o] == ',')
+					++o;
+				else if (code[o] == '[') {
+					++o;
+					while ((o < l) && (code[o] != ']'))
+						++o;
+					if (o < l)
+						o += code[o] == ']';
+				}
+			}
+			pcode = &code[o];
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,187 @@
+/*
+	Multi draw indirect batches with per-draw data in a storage buffer.
+	Uniforms that change per object move into a runtime sized array of a "buffer" block,the batch lays
+	each draw's record out from the reflected fields (jglsl_shader_c::get_draw_layout()) and submits
+	every recorded draw with a single glMultiDrawElementsIndirect.
+	Records and commands go through a jglsl_ubo_ring_c,so a frame never overwrites data in flight.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_multi_draw_c_
+#define _jglsl_multi_draw_c_
+
+#include "jglsl_ubo_ring.hpp"
+
+/*
+	Example usage :
+
+	Shader :
+		struct draw_t { mat4 model; vec4 color; };
+		layout(std430,binding = 0) readonly buffer Draws { draw_t draws[]; };
+		...
+		draw_t d = draws[gl_DrawID];	//Or gl_BaseInstance,see below
+
+	jglsl_multi_draw_c batch;
+	batch.create(*shader,"Draws",4096);
+	const jglsl_block_member_t* model = batch.get_layout().find_field("model");
+	const jglsl_block_member_t* color = batch.get_layout().find_field("color");
+
+	For every frame :
+		shader->bind();
+		glBindVertexArray(vao);
+		for every object :
+			const uint32_t d = batch.add(index_count,first_index,base_vertex);
+			batch.set(d,model,matrix,64);
+			batch.set(d,color,rgba,16);
+		batch.submit(GL_TRIANGLES,GL_UNSIGNED_INT);
+		batch.end_frame();
+
+	Every command gets its draw index as base instance.Without GL 4.6 / ARB_shader_draw_parameters
+	(jglsl_gl_caps().draw_parameters) an instanced vertex attribute (divisor 1) fed from a buffer holding
+	0,1,2... yields the same index.
+*/
+
+//glMultiDrawElementsIndirect command (DrawElementsIndirectCommand)
+struct jglsl_draw_elements_cmd_t {
+	GLuint count;
+	GLuint instance_count;
+	GLuint first_index;
+	GLint base_vertex;
+	GLuint base_instance;
+};
+
+class jglsl_multi_draw_c {
+	private:
+	jglsl_ubo_ring_c m_ring;
+	jglsl_draw_layout_t m_layout;
+	std::vector<uint8_t> m_records;		//Draws recorded since the last submit()
+	std::vector<jglsl_draw_elements_cmd_t> m_commands;
+	uint32_t m_max_draws;
+	uint32_t m_submits;
+
+	public:
+	jglsl_multi_draw_c() : m_max_draws(0),m_submits(0) {}
+
+	/*
+		block : storage block of shader closing with the per-draw array
+		max_draws : draws per submit(),submits_per_frame : submit() calls between end_frame() calls
+	*/
+	bool create(const jglsl_shader_c& shader,const std::string& block,const uint32_t max_draws,
+				const uint32_t submits_per_frame = 1,const uint32_t frames = 3) {
+		if ((max_draws == 0) || (!shader.get_draw_layout(block,m_layout)))
+			return false;
+
+		//Records and commands of one submit,each rounded up to the ring alignment
+		const uint32_t records = m_layout.offset + max_draws * m_layout.stride;
+		const uint32_t commands = max_draws * sizeof(jglsl_draw_elements_cmd_t);
+		GLint align = 0;
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,&align);
+		const uint32_t slack = 2 * ((align > 0) ? align : 256);
+		if (!m_ring.create((records + commands + slack) * submits_per_frame,frames,GL_SHADER_STORAGE_BUFFER))
+			return false;
+
+		m_max_draws = max_draws;
+		m_records.clear();
+		m_commands.clear();
+		m_records.reserve(max_draws * m_layout.stride);
+		m_commands.reserve(max_draws);
+		return true;
+	}
+
+	void destroy() {
+		m_ring.destroy();
+		m_records.clear();
+		m_commands.clear();
+		m_max_draws = 0;
+	}
+
+	inline const jglsl_draw_layout_t& get_layout() const {
+		return m_layout;
+	}
+
+	//Records a draw with a zeroed record,returns its index for set()/get_record() (jglsl_invalid_offset : batch full)
+	uint32_t add(const GLuint count,const GLuint first_index = 0,const GLint base_vertex = 0,const GLuint instance_count = 1) {
+		const uint32_t draw = m_commands.size();
+		if (draw >= m_max_draws)
+			return jglsl_invalid_offset;
+
+		const jglsl_draw_elements_cmd_t cmd = { count,instance_count,first_index,base_vertex,draw };
+		m_commands.push_back(cmd);
+		m_records.resize(m_records.size() + m_layout.stride,0);
+		return draw;
+	}
+
+	inline uint8_t* get_record(const uint32_t draw) {
+		return &m_records[draw * m_layout.stride];
+	}
+
+	inline void set(const uint32_t draw,const jglsl_block_member_t* field,const void* data,const uint32_t size) {
+		if (field)
+			memcpy(get_record(draw) + field->offset,data,size);
+	}
+
+	inline bool set(const uint32_t draw,const std::string& field,const void* data,const uint32_t size) {
+		const jglsl_block_member_t* f = m_layout.find_field(field);
+		set(draw,f,data,size);
+		return f != 0;
+	}
+
+	inline uint32_t get_draw_count() const {
+		return m_commands.size();
+	}
+
+	/*
+		Uploads the records and commands,binds the records to the block's binding and issues a single
+		glMultiDrawElementsIndirect.The program and vertex array have to be bound already.
+		Returns false (nothing drawn) when the ring is full for this frame.
+	*/
+	bool submit(const GLenum mode,const GLenum index_type = GL_UNSIGNED_INT) {
+		const uint32_t n = m_commands.size();
+		if (n == 0)
+			return true;
+
+		//Records start at the element the shader indexes from,the block head before them stays unused
+		const uint32_t records = m_layout.offset + n * m_layout.stride;
+		const uint32_t commands = n * sizeof(jglsl_draw_elements_cmd_t);
+		uint32_t records_offs,commands_offs;
+		uint8_t* rec = m_ring.alloc(records,records_offs);
+		uint8_t* cmd = rec ? m_ring.alloc(commands,commands_offs) : 0;
+		if (!cmd) {
+			m_records.clear();
+			m_commands.clear();
+			return false;
+		}
+
+		memcpy(rec + m_layout.offset,&m_records[0],n * m_layout.stride);
+		memcpy(cmd,&m_commands[0],commands);
+		m_ring.bind(m_layout.binding,records_offs,records);
+		m_ring.upload(commands_offs,commands);
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER,m_ring.get_buffer());
+		glMultiDrawElementsIndirect(mode,index_type,(const void*)(uintptr_t)commands_offs,n,0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER,0);
+
+		++m_submits;
+		m_records.clear();
+		m_commands.clear();
+		return true;
+	}
+
+	//Once per frame,after the last submit()
+	inline void end_frame() {
+		m_ring.end_frame();
+	}
+
+	//submit() calls so far (each one replaces get_draw_count() separate draws)
+	inline uint32_t get_submits() const {
+		return m_submits;
+	}
+
+	inline const jglsl_ubo_ring_c& get_ring() const {
+		return m_ring;
+	}
+};
+
+#endif
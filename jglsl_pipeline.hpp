@@ -0,0 +1,177 @@
+/*
+	Program pipelines (GL 4.1 / ARB_separate_shader_objects) built on demand from separable jglsl_shader_c
+	programs.With N vertex and M fragment variants only N + M programs are linked,each combination
+	becomes a pipeline on first use.Every stage program keeps its own uniform tables.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_pipeline_c_
+#define _jglsl_pipeline_c_
+
+#include "jglsl_shader.hpp"
+
+/*
+	Example usage :
+
+	jglsl_shader_c* vs = new jglsl_shader_c();
+	vs->set_separable(true);
+	vs->load(GL_VERTEX_SHADER,vs_code);
+	vs->finalize();
+
+	jglsl_shader_c* fs = new jglsl_shader_c();
+	fs->set_separable(true);
+	fs->load(GL_FRAGMENT_SHADER,fs_code);
+	fs->finalize();
+
+	jglsl_pipeline_cache_c pipelines;
+
+	For every draw :
+		vs->u_mat4_fv("u_mvp",matrix);	//Each stage has its own uniforms
+		fs->u_4fv("u_color",color);
+		pipelines.bind(*vs,*fs);
+		glDrawElements(...);
+
+	pipelines.remove(*vs);	//Before vs is unloaded,reloaded or deleted (frees its pipelines)
+	watch.set_reload_hook(jglsl_pipeline_cache_c::reload_hook,&pipelines);	//Same for reloads by a jglsl_source_watch_c
+
+	Pipelines are keyed by program serial (jglsl_shader_c::get_program_serial()),a stage relinked by
+	reload(),swapped for a specialized variant or unloaded never matches its old pipelines again,
+	even when GL hands out the freed program name again.
+*/
+class jglsl_pipeline_cache_c {
+	private:
+	typedef std::map<std::vector<uint64_t>,GLuint> pipelines_t;	//Program serial of every stage -> pipeline
+	pipelines_t m_pipelines;
+	GLuint m_bound;		//0 : not known
+	uint32_t m_builds;
+	std::string m_log;
+
+	GLuint build(jglsl_shader_c* const* stages,const uint32_t count,const std::vector<GLuint>& programs) {
+		GLuint pipeline = 0;
+		glGenProgramPipelines(1,&pipeline);
+		for (uint32_t i = 0;i < count;++i)
+			glUseProgramStages(pipeline,stages[i]->get_stage_bits(),programs[i]);
+		++m_builds;
+
+#ifndef NDEBUG
+		//Interface mismatches between the stages only show up here
+		GLint status = GL_TRUE,log_len = 0;
+		glValidateProgramPipeline(pipeline);
+		glGetProgramPipelineiv(pipeline,GL_VALIDATE_STATUS,&status);
+		glGetProgramPipelineiv(pipeline,GL_INFO_LOG_LENGTH,&log_len);
+		if ((status == GL_FALSE) && (log_len > 1)) {
+			std::vector<GLchar> log(log_len);
+			glGetProgramPipelineInfoLog(pipeline,log_len,0,&log[0]);
+			m_log += "PPL:";
+			m_log.append(&log[0],log_len - 1);
+			m_log += '\n';
+		}
+#endif
+		return pipeline;
+	}
+
+	public:
+	jglsl_pipeline_cache_c() : m_bound(0),m_builds(0) {}
+
+	~jglsl_pipeline_cache_c() {
+		clear();
+	}
+
+	/*
+		Pipeline of the given separable programs (one per stage),built on first use.
+		Pending links are completed and staged uniforms sent first,returns 0 if one of them failed to link.
+	*/
+	GLuint get(jglsl_shader_c* const* stages,const uint32_t count) {
+		std::vector<uint64_t> key(count);
+		for (uint32_t i = 0;i < count;++i) {
+			stages[i]->prepare_stages();
+			if (!stages[i]->is_linked())
+				return 0;
+			key[i] = stages[i]->get_program_serial();
+		}
+
+		pipelines_t::iterator it = m_pipelines.find(key);
+		if (it != m_pipelines.end())
+			return it->second;
+
+		std::vector<GLuint> programs(count);
+		for (uint32_t i = 0;i < count;++i)
+			programs[i] = stages[i]->get_program();
+		const GLuint pipeline = build(stages,count,programs);
+		m_pipelines.insert(std::make_pair(key,pipeline));
+		return pipeline;
+	}
+
+	bool bind(jglsl_shader_c* const* stages,const uint32_t count) {
+		const GLuint pipeline = get(stages,count);
+		if (pipeline == 0)
+			return false;
+
+		jglsl_use_program(0);	//A program in use takes precedence over the bound pipeline
+		if (m_bound != pipeline) {
+			glBindProgramPipeline(pipeline);
+			m_bound = pipeline;
+		}
+		return true;
+	}
+
+	bool bind(jglsl_shader_c& vs,jglsl_shader_c& fs) {
+		jglsl_shader_c* stages[2] = { &vs,&fs };
+		return bind(stages,2);
+	}
+
+	//After glBindProgramPipeline calls made outside the cache
+	inline void invalidate_bound() {
+		m_bound = 0;
+	}
+
+	//Deletes every pipeline using the current program of stage
+	inline void remove(const jglsl_shader_c& stage) {
+		remove(stage.get_program_serial());
+	}
+
+	//Deletes every pipeline using the program with this serial (jglsl_shader_c::get_program_serial())
+	void remove(const uint64_t serial) {
+		for (pipelines_t::iterator it = m_pipelines.begin();it != m_pipelines.end();) {
+			if (std::find(it->first.begin(),it->first.end(),serial) == it->first.end()) {
+				++it;
+				continue;
+			}
+
+			if (m_bound == it->second)
+				m_bound = 0;
+			glDeleteProgramPipelines(1,&it->second);
+			m_pipelines.erase(it++);
+		}
+	}
+
+	//jglsl_source_watch_c::set_reload_hook() callback,cache : the jglsl_pipeline_cache_c
+	static void reload_hook(void* cache,jglsl_shader_c&,const uint64_t old_serial) {
+		((jglsl_pipeline_cache_c*)cache)->remove(old_serial);
+	}
+
+	void clear() {
+		for (pipelines_t::iterator it = m_pipelines.begin();it != m_pipelines.end();++it)
+			glDeleteProgramPipelines(1,&it->second);
+		m_pipelines.clear();
+		m_bound = 0;
+	}
+
+	inline uint32_t get_pipeline_count() const {
+		return m_pipelines.size();
+	}
+
+	//Pipelines built so far (each one replaces a link of a monolithic program)
+	inline uint32_t get_builds() const {
+		return m_builds;
+	}
+
+	//Validation messages of debug builds
+	inline const char* get_log() const {
+		return m_log.c_str();
+	}
+};
+
+#endif
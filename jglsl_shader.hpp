@@ -20,621 +20,5421 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <stdint.h>
 #include <iostream>
 #include <vector>
 #include <map>
+#include <string>
+#include <type_traits>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+
+/*FNV-1a 32bit. The recursive form is usable in constant expressions (stops at the first NUL,so
+  char buffers holding shorter names hash the same as the equivalent literal)*/
+static constexpr uint32_t jglsl_fnv1a(const char* s,const size_t n,const uint32_t h = 2166136261u) {
+	return ((n == 0) || (*s == 0)) ? h : jglsl_fnv1a(s + 1,n - 1,(h ^ (uint8_t)*s) * 16777619u);
+}
+
+static inline uint32_t jglsl_fnv1a_rt(const char* s,const size_t n) {
+	uint32_t h = 2166136261u;
+	for (size_t i = 0;(i < n) && (s[i] != 0);++i)
+		h = (h ^ (uint8_t)s[i]) * 16777619u;
+	return h;
+}
+
+static inline uint64_t jglsl_fnv1a64(const void* data,const size_t n,uint64_t h = 14695981039346656037ull) {
+	const uint8_t* p = (const uint8_t*)data;
+	for (size_t i = 0;i < n;++i)
+		h = (h ^ p[i]) * 1099511628211ull;
+	return h;
+}
+
+//Non owning view into shader source (the parser never copies or NUL terminates tokens)
+struct jglsl_span_t {
+	const char* ptr;
+	uint32_t len;
+
+	//Against literals the length folds to a constant and the compare is inlined
+	inline bool operator==(const char* s) const {
+		return (len != 0) && (len == strlen(s)) && (memcmp(ptr,s,len) == 0);
+	}
+
+	inline bool operator!=(const char* s) const {
+		return !(*this == s);
+	}
+
+	inline bool operator==(const jglsl_span_t& s) const {
+		return (len == s.len) && (memcmp(ptr,s.ptr,len) == 0);
+	}
+
+	inline std::string str() const {
+		return std::string(ptr,len);
+	}
+};
 
-/*Define it to remove all glUniform##() macros*/
-#undef JGLSL_NO_GLUNIFORM_MACROS
 /*
-	Example usage :
+	Uniform handle keyed by name hash.
+	String literals hash at compile time (use JGLSL_U("name") to force it),std::string/char* hash at runtime.
+	The name pointer is only read to confirm a hash match,it must outlive the call.
+*/
+class jglsl_uniform_key_t {
+	private:
+	uint32_t m_hash;
+	const char* m_name;
 
-	jglsl_shader_c* shader = new jglsl_shader_c();
-	
-    char* v_shader = read_nullterm_text_file("shaders/test.vert");
-    char* f_shader = read_nullterm_text_file("shaders/test.frag");
-    shader->load(GL_FRAGMENT_SHADER,f_shader,strlen(f_shader));
-    shader->load(GL_VERTEX_SHADER,v_shader,strlen(v_shader));
-    delete v_shader; delete f_shader;
+	public:
+	template <size_t N>
+	constexpr jglsl_uniform_key_t(const char (&name)[N]) : m_hash(jglsl_fnv1a(name,N - 1)),m_name(name) {}
+
+	template <typename char_t>
+	jglsl_uniform_key_t(const char_t* const& name) : m_hash(jglsl_fnv1a_rt(name,(size_t)-1)),m_name(name) {}
+
+	jglsl_uniform_key_t(const std::string& name) : m_hash(jglsl_fnv1a_rt(name.c_str(),name.length())),m_name(name.c_str()) {}
+
+	constexpr jglsl_uniform_key_t(const char* name,const uint32_t hash) : m_hash(hash),m_name(name) {}
+
+	constexpr uint32_t hash() const { return m_hash; }
+	constexpr const char* name() const { return m_name; }
+};
+
+#define JGLSL_U(_name_) jglsl_uniform_key_t(_name_,std::integral_constant<uint32_t,jglsl_fnv1a(_name_,sizeof(_name_) - 1)>::value)
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+#ifndef GL_MAX_IMAGE_UNITS
+#define GL_MAX_IMAGE_UNITS 0x8F38
+#endif
+
+/*
+	Context capabilities,detected on first use.
+	Call jglsl_gl_caps_refresh() after switching to a context with a different feature set.
+*/
+struct jglsl_gl_caps_t {
+	bool detected;
+	uint32_t major;
+	uint32_t minor;
+	bool program_uniform;		//glProgramUniform* (GL 4.1 / ARB_separate_shader_objects)
+	bool parallel_compile;		//GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile
+	bool parallel_compile_khr;	//The KHR entry points are present (ARB only drivers export glMaxShaderCompilerThreadsARB)
+	bool program_binary;		//glGetProgramBinary/glProgramBinary with at least one binary format
+	bool buffer_storage;		//glBufferStorage,persistent mappings (GL 4.4 / ARB_buffer_storage)
+	bool program_interface;		//glGetProgramInterfaceiv/glGetProgramResourceiv (GL 4.3 / ARB_program_interface_query)
+	bool draw_parameters;		//gl_DrawID/gl_BaseInstance in shaders (GL 4.6 / ARB_shader_draw_parameters)
+	bool bindless_texture;		//Resident 64bit texture handles as sampler values (ARB_bindless_texture)
+	uint64_t driver_hash;		//GL_VENDOR/GL_RENDERER/GL_VERSION,part of every program binary cache key
+
+	inline bool version(const uint32_t maj,const uint32_t min) const {
+		return (major > maj) || ((major == maj) && (minor >= min));
+	}
+};
+
+//Major/minor of a GL_VERSION string,0 if missing
+static inline uint32_t jglsl_parse_gl_version(const char* v,uint32_t* minor = 0) {
+	uint32_t major = 0;
+	if (minor)
+		*minor = 0;
+	if (v != 0) {
+		while ((*v != 0) && ((*v < '0') || (*v > '9')))	//GLES: "OpenGL ES 3.2 ..."
+			++v;
+		major = strtoul(v,(char**)&v,10);
+		if ((*v == '.') && minor)
+			*minor = strtoul(v + 1,0,10);
+	}
+	return major;
+}
+
+static inline bool jglsl_has_extension(const char* ext) {
+	//glGetStringi needs GL 3.0 / GLES 3.0
+	if (jglsl_parse_gl_version((const char*)glGetString(GL_VERSION)) >= 3) {
+		GLint n = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS,&n);
+		for (GLint i = 0;i < n;++i) {
+			const char* e = (const char*)glGetStringi(GL_EXTENSIONS,(GLuint)i);
+			if ((e != 0) && (strcmp(e,ext) == 0))
+				return true;
+		}
+		return false;
+	}
+
+	const char* all = (const char*)glGetString(GL_EXTENSIONS);
+	const size_t len = strlen(ext);
+	for (const char* p = all;(p != 0) && ((p = strstr(p,ext)) != 0);p += len) {
+		if (((p == all) || (p[-1] == ' ')) && ((p[len] == ' ') || (p[len] == 0)))
+			return true;
+	}
+	return false;
+}
+
+static inline void jglsl_detect_gl_caps(jglsl_gl_caps_t& caps) {
+	caps.major = jglsl_parse_gl_version((const char*)glGetString(GL_VERSION),&caps.minor);
+
+	caps.program_uniform = caps.version(4,1) || jglsl_has_extension("GL_ARB_separate_shader_objects");
+	caps.parallel_compile_khr = jglsl_has_extension("GL_KHR_parallel_shader_compile");
+	caps.parallel_compile = caps.parallel_compile_khr || jglsl_has_extension("GL_ARB_parallel_shader_compile");
+	GLint formats = 0;
+	if (caps.version(4,1) || jglsl_has_extension("GL_ARB_get_program_binary"))
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS,&formats);
+	caps.program_binary = formats > 0;
+	caps.buffer_storage = caps.version(4,4) || jglsl_has_extension("GL_ARB_buffer_storage");
+	caps.program_interface = caps.version(4,3) || jglsl_has_extension("GL_ARB_program_interface_query");
+	caps.draw_parameters = caps.version(4,6) || jglsl_has_extension("GL_ARB_shader_draw_parameters");
+	caps.bindless_texture = jglsl_has_extension("GL_ARB_bindless_texture");
+
+	caps.driver_hash = jglsl_fnv1a64(0,0);
+	const GLenum ids[] = { GL_VENDOR,GL_RENDERER,GL_VERSION };
+	for (uint32_t i = 0;i < 3;++i) {
+		const char* str = (const char*)glGetString(ids[i]);
+		if (str != 0)
+			caps.driver_hash = jglsl_fnv1a64(str,strlen(str) + 1,caps.driver_hash);
+	}
+
+	//Let the driver use as many threads as it likes
+#ifdef GL_KHR_parallel_shader_compile
+	if (caps.parallel_compile_khr)
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+#endif
+#ifdef GL_ARB_parallel_shader_compile
+	if (caps.parallel_compile && !caps.parallel_compile_khr)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+#endif
+	caps.detected = true;
+}
+
+inline jglsl_gl_caps_t& jglsl_gl_caps_storage() {
+	static jglsl_gl_caps_t caps;	//Zero initialized,detected == false
+	return caps;
+}
+
+inline const jglsl_gl_caps_t& jglsl_gl_caps() {
+	jglsl_gl_caps_t& caps = jglsl_gl_caps_storage();
+	if (!caps.detected)
+		jglsl_detect_gl_caps(caps);
+	return caps;
+}
+
+inline void jglsl_gl_caps_refresh() {
+	jglsl_gl_caps_storage().detected = false;
+}
+
+/*
+	Program currently in use,shared by all instances so bind() can skip glUseProgram for it.
+	Call jglsl_invalidate_bound_program() after glUseProgram calls made outside the wrapper or
+	after making another context current.
+*/
+struct jglsl_bind_state_t {
+	GLuint program;			//jglsl_unknown_program : not known,the next bind() always calls GL
+	uint32_t switches;		//glUseProgram calls since the last reset
+	bool keep_bound;		//unbind() leaves the last program in use
+};
+
+static const GLuint jglsl_unknown_program = 0xFFFFFFFFu;
+
+inline jglsl_bind_state_t& jglsl_bind_state() {
+	static jglsl_bind_state_t state = { jglsl_unknown_program,0,false };
+	return state;
+}
+
+inline void jglsl_invalidate_bound_program() {
+	jglsl_bind_state().program = jglsl_unknown_program;
+}
+
+//Sorted draws rarely need program 0 in between : while set unbind() does nothing
+inline void jglsl_set_keep_bound(const bool keep) {
+	jglsl_bind_state().keep_bound = keep;
+}
+
+//Real program switches,read and reset once per frame for profiling
+inline uint32_t jglsl_get_program_switches() {
+	return jglsl_bind_state().switches;
+}
+
+inline void jglsl_reset_program_switches() {
+	jglsl_bind_state().switches = 0;
+}
+
+/*
+	Instrumentation,compiled in with JGLSL_PROFILE defined before the include (get_stats() stays
+	available but reads zeroes otherwise).
+	CPU phases accumulate from creation on,phases nest (load includes parse,finalize includes locations).
+	Per frame counters and GPU times are taken by jglsl_profile_end_frame().
+*/
+enum {
+	JGLSL_PHASE_LOAD = 0,		//load()/load_async()/commit()/reload() (compile submission and parse)
+	JGLSL_PHASE_PARSE,			//Source scans (reflection cache hits skip it)
+	JGLSL_PHASE_FINALIZE,		//finalize_async() and the link completion
+	JGLSL_PHASE_LOCATIONS,		//Location/block queries once linked
+	JGLSL_PHASE_UPLOADS,		//glUniform*/glProgramUniform* calls (setters and flush())
+	JGLSL_PHASE_COUNT
+};
+
+static inline const char* jglsl_phase_name(const uint32_t phase) {
+	static const char* names[] = { "load","parse","finalize","locations","uploads" };
+	return (phase < JGLSL_PHASE_COUNT) ? names[phase] : "";
+}
+
+struct jglsl_profile_phase_t {
+	uint64_t ns;
+	uint32_t calls;
+};
+
+struct jglsl_profile_stats_t {
+	jglsl_profile_phase_t cpu[JGLSL_PHASE_COUNT];
+
+	//Last finished frame
+	uint32_t frame_uniform_calls;	//GL calls issued (skipped ones are not counted)
+	uint32_t frame_binds;
+
+	//GPU time of the bind() spans of the frame before the last one (results are read one frame late to avoid stalls)
+	uint64_t gpu_ns;
+	uint32_t gpu_spans;
+	uint32_t gpu_frame;				//jglsl_profile_frame() of these results
+	uint32_t gpu_dropped;			//Spans whose result was still not available a frame later
+
+	jglsl_profile_stats_t() {
+		memset(this,0,sizeof(*this));
+	}
+};
+
+//jglsl_shader_c::finalize_all() results
+struct jglsl_finalize_stats_t {
+	uint32_t programs;
+	uint32_t linked;
+	uint32_t failed;			//Link or compile errors (logs in each instance's get_log())
+	uint64_t submit_ns;			//First pass : deferred compiles and glLinkProgram of every program
+	uint64_t collect_ns;		//Second pass : status/logs and locations
+
+	jglsl_finalize_stats_t() {
+		memset(this,0,sizeof(*this));
+	}
+};
+
+/*
+	GL_TIME_ELAPSED spans : from the bind() of an instance to the next bind() of another instance
+	(or unbind()).Only one such query can be active,the application must not run its own.
+*/
+class jglsl_shader_c;
+
+struct jglsl_profile_state_t {
+	uint32_t frame;
+	bool gpu_timers;
+	GLuint active_query;		//0 : none
+	const jglsl_shader_c* active_owner;
+	std::vector<jglsl_shader_c*> instances;	//Visited by jglsl_profile_end_frame() (JGLSL_PROFILE builds)
+};
+
+inline jglsl_profile_state_t& jglsl_profile_state() {
+	static jglsl_profile_state_t state = { 0,false,0,0,std::vector<jglsl_shader_c*>() };
+	return state;
+}
+
+//Off by default (needs GL 3.3 / ARB_timer_query)
+inline void jglsl_set_gpu_timers(const bool enable) {
+	jglsl_profile_state().gpu_timers = enable;
+}
+
+inline uint32_t jglsl_profile_frame() {
+	return jglsl_profile_state().frame;
+}
+
+static inline void jglsl_end_gpu_span() {
+	jglsl_profile_state_t& state = jglsl_profile_state();
+	if (state.active_query != 0) {
+		glEndQuery(GL_TIME_ELAPSED);
+		state.active_query = 0;
+		state.active_owner = 0;
+	}
+}
+
+#ifdef JGLSL_PROFILE
+struct jglsl_phase_timer_t {
+	jglsl_profile_phase_t& phase;
+	const std::chrono::steady_clock::time_point start;
+
+	jglsl_phase_timer_t(jglsl_profile_phase_t& p) : phase(p),start(std::chrono::steady_clock::now()) {}
+
+	~jglsl_phase_timer_t() {
+		phase.ns += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		++phase.calls;
+	}
+};
+#define JGLSL_PROFILE_PHASE(_phase_) jglsl_phase_timer_t jglsl_phase_timer(m_stats.cpu[_phase_])
+#else
+#define JGLSL_PROFILE_PHASE(_phase_)
+#endif
+
+static inline void jglsl_use_program(const GLuint program) {
+	jglsl_bind_state_t& state = jglsl_bind_state();
+	if (state.program == program)
+		return;
+
+	glUseProgram(program);
+	state.program = program;
+	++state.switches;
+}
+
+#ifdef GL_ARB_bindless_texture
+/*
+	Handle of texture (its own sampler state) for jglsl_shader_c::u_tex_handle(),made resident.
+	Make it non resident (glMakeTextureHandleNonResidentARB) before the texture is deleted.
+*/
+static inline GLuint64 jglsl_resident_texture_handle(const GLuint texture) {
+	const GLuint64 handle = glGetTextureHandleARB(texture);
+	if ((handle != 0) && (!glIsTextureHandleResidentARB(handle)))
+		glMakeTextureHandleResidentARB(handle);
+	return handle;
+}
+#endif
+
+//Interface block memory layouts
+enum {
+	JGLSL_LAYOUT_SHARED = 0,	//shared/packed : implementation defined,offsets are queried from GL once linked
+	JGLSL_LAYOUT_STD140,
+	JGLSL_LAYOUT_STD430
+};
+
+static const uint32_t jglsl_invalid_offset = 0xFFFFFFFFu;
+
+struct jglsl_block_member_t {
+	std::string name;		//"member","member.field" or "array[2].field" (struct arrays are expanded)
+	std::string type;		//Builtin type
+	uint32_t offset;		//From the start of the block (jglsl_invalid_offset : not known)
+	uint32_t array_count;	//1 : not an array,0 : runtime sized (also fields of runtime sized struct arrays)
+	uint32_t array_stride;	//0 : not an array
+	uint32_t matrix_stride;	//0 : not a matrix
+	bool row_major;
+};
+
+//Uniform or shader storage ("buffer") interface block
+struct jglsl_uniform_block_t {
+	std::string name;		//Block name as seen by the API
+	std::string instance;	//Empty for anonymous blocks
+	uint32_t layout;
+	uint32_t size;			//Bytes (jglsl_invalid_offset : not known)
+	uint32_t index;			//Block (storage blocks : resource) index in the linked program (GL_INVALID_INDEX : inactive)
+	uint32_t binding;		//layout(binding = N) (jglsl_invalid_offset : not given,see bind_block())
+	std::vector<jglsl_block_member_t> members;
+
+	const jglsl_block_member_t* find_member(const std::string& member) const {
+		for (uint32_t i = 0,j = members.size();i < j;++i) {
+			if (members[i].name == member)
+				return &members[i];
+		}
+		return 0;
+	}
+};
+
+/*
+	One element of a storage block's runtime sized array ("draw_t draws[];"),the per-draw record of
+	multi draw indirect submissions (see jglsl_multi_draw.hpp).
+	Field offsets are from the element start,names are relative to it ("model","material.color").
+*/
+struct jglsl_draw_layout_t {
+	uint32_t binding;		//Of the storage block
+	uint32_t offset;		//First element within the block
+	uint32_t stride;		//Bytes per element
+	std::vector<jglsl_block_member_t> fields;
+
+	const jglsl_block_member_t* find_field(const std::string& field) const {
+		for (uint32_t i = 0,j = fields.size();i < j;++i) {
+			if (fields[i].name == field)
+				return &fields[i];
+		}
+		return 0;
+	}
+};
+
+/*
+	Active vertex shader input as glVertexAttrib*Pointer / glVertexAttrib*Format take it.
+	Matrices span one location per column,each column holding components values.
+	dvec3/dvec4 columns take two locations each (column c starts at location + c * locations / columns).
+*/
+struct jglsl_vertex_attrib_t {
+	std::string name;
+	GLuint location;
+	GLint components;	//1..4
+	GLenum format;		//GL_FLOAT,GL_DOUBLE (glVertexAttribL*),GL_INT/GL_UNSIGNED_INT (glVertexAttribI*)
+	uint32_t columns;	//Matrix columns,1 for scalars and vectors
+	uint32_t locations;	//Consecutive locations used
+};
+
+/*
+	#define lines of one permutation.load() inserts them after the #version line of the source,
+	the scanner evaluates #if/#ifdef against them and against the source's own #defines.
+*/
+struct jglsl_define_set_t {
+	std::vector<std::string> names;
+	std::vector<std::string> values;
+
+	jglsl_define_set_t& add(const std::string& name,const std::string& value = "1") {
+		names.push_back(name);
+		values.push_back(value);
+		return *this;
+	}
+
+	inline bool empty() const {
+		return names.empty();
+	}
+
+	std::string text() const {
+		std::string t;
+		for (uint32_t i = 0,j = names.size();i < j;++i)
+			t += "#define " + names[i] + " " + values[i] + "\n";
+		return t;
+	}
+
+	uint64_t hash(uint64_t h = jglsl_fnv1a64(0,0)) const {
+		for (uint32_t i = 0,j = names.size();i < j;++i) {
+			h = jglsl_fnv1a64(names[i].c_str(),names[i].length() + 1,h);
+			h = jglsl_fnv1a64(values[i].c_str(),values[i].length() + 1,h);
+		}
+		return h;
+	}
+
+	static const jglsl_define_set_t& none() {
+		static const jglsl_define_set_t set;
+		return set;
+	}
+};
+
+//Declarations found by the scanner (names with their builtin types,structs flattened)
+struct jglsl_scan_result_t {
+	std::vector<std::string> uniforms,uniform_types;
+	std::vector<uint32_t> uniform_counts;	//1 : not an array,jglsl_invalid_offset : size taken from GL once linked
+	std::vector<uint32_t> uniform_locations;	//Explicit layout(location = N) (jglsl_invalid_offset : not given)
+	std::vector<uint32_t> uniform_bindings;		//Explicit layout(binding = N) of opaque types
+	std::vector<std::string> attributes,attribute_types;	//"attribute" and vertex stage "in" declarations
+	std::vector<uint32_t> attribute_locations;
+	std::vector<std::string> inputs,input_types;
+	std::vector<uint32_t> input_locations;
+	std::vector<std::string> outputs,output_types;
+	std::vector<jglsl_uniform_block_t> blocks;
+	std::vector<jglsl_uniform_block_t> storage_blocks;
+	uint32_t local_size[3];		//Compute workgroup size from layout(local_size_x = ...) in (0 : not declared)
+
+	jglsl_scan_result_t() {
+		local_size[0] = local_size[1] = local_size[2] = 0;
+	}
+
+	void clear() {
+		uniforms.clear();
+		uniform_types.clear();
+		uniform_counts.clear();
+		uniform_locations.clear();
+		uniform_bindings.clear();
+		attributes.clear();
+		attribute_types.clear();
+		attribute_locations.clear();
+		inputs.clear();
+		input_types.clear();
+		input_locations.clear();
+		outputs.clear();
+		output_types.clear();
+		blocks.clear();
+		storage_blocks.clear();
+		local_size[0] = local_size[1] = local_size[2] = 0;
+	}
+
+	//Adds the declarations of another source (blocks declared by both are kept once)
+	void append(const jglsl_scan_result_t& r) {
+		uniforms.insert(uniforms.end(),r.uniforms.begin(),r.uniforms.end());
+		uniform_types.insert(uniform_types.end(),r.uniform_types.begin(),r.uniform_types.end());
+		uniform_counts.insert(uniform_counts.end(),r.uniform_counts.begin(),r.uniform_counts.end());
+		uniform_locations.insert(uniform_locations.end(),r.uniform_locations.begin(),r.uniform_locations.end());
+		uniform_bindings.insert(uniform_bindings.end(),r.uniform_bindings.begin(),r.uniform_bindings.end());
+		attributes.insert(attributes.end(),r.attributes.begin(),r.attributes.end());
+		attribute_types.insert(attribute_types.end(),r.attribute_types.begin(),r.attribute_types.end());
+		attribute_locations.insert(attribute_locations.end(),r.attribute_locations.begin(),r.attribute_locations.end());
+		inputs.insert(inputs.end(),r.inputs.begin(),r.inputs.end());
+		input_types.insert(input_types.end(),r.input_types.begin(),r.input_types.end());
+		input_locations.insert(input_locations.end(),r.input_locations.begin(),r.input_locations.end());
+		outputs.insert(outputs.end(),r.outputs.begin(),r.outputs.end());
+		output_types.insert(output_types.end(),r.output_types.begin(),r.output_types.end());
+
+		append_blocks(blocks,r.blocks);
+		append_blocks(storage_blocks,r.storage_blocks);
+		if (r.local_size[0] != 0) {
+			for (uint32_t i = 0;i < 3;++i)
+				local_size[i] = r.local_size[i];
+		}
+	}
+
+	static void append_blocks(std::vector<jglsl_uniform_block_t>& dst,const std::vector<jglsl_uniform_block_t>& src) {
+		for (uint32_t i = 0,j = src.size();i < j;++i) {
+			bool found = false;
+			for (uint32_t k = 0,w = dst.size();(k < w) && (!found);++k)
+				found = dst[k].name == src[i].name;
+			if (!found)
+				dst.push_back(src[i]);
+		}
+	}
+
+	//Every uniform and attribute has an explicit location,linking needs no location queries
+	bool all_located() const {
+		return (std::find(uniform_locations.begin(),uniform_locations.end(),jglsl_invalid_offset) == uniform_locations.end()) &&
+			(std::find(attribute_locations.begin(),attribute_locations.end(),jglsl_invalid_offset) == attribute_locations.end());
+	}
+};
+
+/*
+	Name -> value table with open addressing (linear probe).
+	Names are interned back to back into one arena and slots refer to them by offset,so a table costs
+	two allocations however many names it holds.Entries are never removed,release() frees everything at once.
+*/
+struct jglsl_name_table_t {
+	struct slot_t {
+		uint32_t hash;
+		uint32_t name;		//Offset into names,jglsl_invalid_offset marks an empty slot
+		uint32_t value;
+	};
+
+	std::vector<char> names;	//NUL terminated
+	std::vector<slot_t> slots;
+	uint32_t mask;
+	uint32_t count;
+
+	jglsl_name_table_t() : mask(0),count(0) {}
+
+	inline uint32_t size() const {
+		return count;
+	}
+
+	inline const char* get_name(const slot_t& slot) const {
+		return &names[slot.name];
+	}
+
+	//0 : not found
+	const uint32_t* find(const char* name,const uint32_t len) const {
+		if (slots.empty())
+			return 0;
+
+		const uint32_t h = jglsl_fnv1a_rt(name,len);
+		for (uint32_t i = h & mask;;i = (i + 1) & mask) {
+			const slot_t& slot = slots[i];
+			if (slot.name == jglsl_invalid_offset)
+				return 0;
+			if ((slot.hash == h) && (memcmp(&names[slot.name],name,len) == 0) && (names[slot.name + len] == '\0'))
+				return &slot.value;
+		}
+	}
+
+	inline const uint32_t* find(const std::string& name) const {
+		return find(name.c_str(),name.length());
+	}
+
+	//false : already present (value left as is)
+	bool insert(const std::string& name,const uint32_t value) {
+		if (find(name))
+			return false;
+
+		if ((count * 2) >= slots.size())
+			grow();
+
+		const slot_t slot = { jglsl_fnv1a_rt(name.c_str(),name.length()),(uint32_t)names.size(),value };
+		names.insert(names.end(),name.c_str(),name.c_str() + name.length() + 1);
+		place(slot);
+		++count;
+		return true;
+	}
+
+	void release() {
+		std::vector<char>().swap(names);
+		std::vector<slot_t>().swap(slots);
+		mask = 0;
+		count = 0;
+	}
+
+	private:
+	void place(const slot_t& slot) {
+		uint32_t i = slot.hash & mask;
+		while (slots[i].name != jglsl_invalid_offset)
+			i = (i + 1) & mask;
+		slots[i] = slot;
+	}
+
+	//Hashes are kept in the slots,growing only moves them
+	void grow() {
+		std::vector<slot_t> old;
+		old.swap(slots);
+
+		const slot_t empty = { 0,jglsl_invalid_offset,0 };
+		const uint32_t cap = old.empty() ? 16 : (uint32_t)old.size() * 2;
+		slots.assign(cap,empty);
+		mask = cap - 1;
+
+		for (uint32_t i = 0,j = old.size();i < j;++i) {
+			if (old[i].name != jglsl_invalid_offset)
+				place(old[i]);
+		}
+	}
+};
+
+//Shadow copy bookkeeping of the last value sent to GL for a reflected uniform
+struct jglsl_uniform_state_t {
+	uint32_t offset;	//Into the shadow block
+	uint32_t size;		//Reserved bytes,all array elements (0 : type unknown,never cached)
+	uint32_t bytes;		//Valid bytes from the first element (0 : value unknown)
+	uint32_t location;
+	uint32_t count;		//Array elements at location,location + 1...
+	uint16_t kind;		//Setter kind of the staged value (batched mode)
+	uint16_t dirty;		//Staged but not yet sent to GL (batched mode)
+	uint32_t dirty_begin;	//Staged byte range,whole elements (valid while dirty)
+	uint32_t dirty_end;
+};
+
+//Array uniform,element k is at location + k * stride
+struct jglsl_uniform_array_t {
+	uint32_t location;
+	uint32_t count;		//0 : not found
+	uint32_t stride;	//0 : elements are not evenly spaced,look up each "name[k].field" instead
+};
+
+//Texture or image unit of a reflected sampler or image uniform,see jglsl_shader_c::get_texture_units()
+struct jglsl_texture_unit_t {
+	std::string name;
+	uint32_t location;
+	uint32_t count;		//Array elements,element k uses unit + k
+	uint32_t unit;
+	bool image;			//Image unit (glBindImageTexture) rather than texture unit
+};
+
+//glDispatchComputeIndirect arguments (DispatchIndirectCommand)
+struct jglsl_dispatch_args_t {
+	GLuint num_groups_x;
+	GLuint num_groups_y;
+	GLuint num_groups_z;
+};
+
+//Stable reference to a uniform,see jglsl_shader_c::get_uniform_handle()
+struct jglsl_uniform_handle_t {
+	uint32_t index;
+};
+
+class jglsl_program_registry_c;
+
+//Program serials are never reused,unlike GL program names
+inline uint64_t jglsl_next_program_serial() {
+	static uint64_t serial = 0;
+	return ++serial;
+}
+
+/*
+	A linked program and everything resolved from it.
+	Shared by every jglsl_shader_c that loaded the same sources through one registry,uniform values
+	belong to the GL program so the shadow copies are shared as well.
+*/
+struct jglsl_program_t {
+	GLuint id;
+	uint64_t serial;
+	uint32_t refs;
+	uint64_t key;							//Source hash
+	jglsl_program_registry_c* registry;		//0 : not registered
+
+	jglsl_name_table_t attributes;			//Name -> location
+	jglsl_name_table_t uniforms;
+
+	std::vector<jglsl_uniform_state_t> uniform_states;
+	std::vector<uint8_t> uniform_shadow;
+	std::vector<uint32_t> location_states;	//Location -> uniform_states index + 1
+	std::vector<uint32_t> dirty_states;
+	std::vector<jglsl_uniform_block_t> blocks;
+	std::vector<jglsl_uniform_block_t> storage_blocks;
+	std::vector<jglsl_texture_unit_t> texture_units;
+	std::vector<std::string> specialized;	//Uniforms compiled in as constants,kept as inactive entries
+	uint32_t local_size[3];					//Compute workgroup size (0 : not a compute program)
+	std::vector<jglsl_vertex_attrib_t> vertex_layout;	//By location
+	uint64_t vertex_layout_hash;
+	GLbitfield stage_bits;		//GL_*_SHADER_BIT of the linked stages
+
+	//Pending link
+	bool link_pending;
+	bool link_status;
+	uint32_t links;							//Completed links,instances resolved against an older count refresh their handles
+	std::vector<GLuint> shaders;
+	std::vector<GLuint> unchecked_shaders;	//Compile status not queried yet
+	jglsl_scan_result_t reflection;
+	std::string binary_path;				//Binary cache file written once linked (empty : none)
+
+	jglsl_program_t() : id(0),serial(jglsl_next_program_serial()),refs(0),key(0),registry(0),vertex_layout_hash(0),stage_bits(0),link_pending(false),link_status(false),links(0) {
+		local_size[0] = local_size[1] = local_size[2] = 0;
+	}
+
+	//Stand-in of instances without a program,never modified
+	static jglsl_program_t* null_program() {
+		static jglsl_program_t prog;
+		return &prog;
+	}
+};
+
+/*
+	Deduplicates programs by source hash : instances attached with set_registry() that load the same
+	sources share one GL program and its location tables,it is deleted along with its last user.
+	Attached instances should register the same builtin types (they are not part of the key).
+	Programs still in use when the registry goes away are simply detached from it.
+*/
+class jglsl_program_registry_c {
+	friend class jglsl_shader_c;
+
+	private:
+	std::map<uint64_t,jglsl_program_t*> m_programs;
+	uint32_t m_hits;
+
+	jglsl_program_t* acquire(const uint64_t key) {
+		std::map<uint64_t,jglsl_program_t*>::iterator it = m_programs.find(key);
+		if (it == m_programs.end())
+			return 0;
+
+		++m_hits;
+		++it->second->refs;
+		return it->second;
+	}
+
+	void insert(jglsl_program_t* prog) {
+		prog->registry = this;
+		m_programs[prog->key] = prog;
+	}
+
+	void remove(jglsl_program_t* prog) {
+		std::map<uint64_t,jglsl_program_t*>::iterator it = m_programs.find(prog->key);
+		if ((it != m_programs.end()) && (it->second == prog))
+			m_programs.erase(it);
+		prog->registry = 0;
+	}
+
+	public:
+	jglsl_program_registry_c() : m_hits(0) {}
+
+	~jglsl_program_registry_c() {
+		for (std::map<uint64_t,jglsl_program_t*>::iterator it = m_programs.begin();it != m_programs.end();++it)
+			it->second->registry = 0;
+	}
+
+	inline uint32_t get_program_count() const {
+		return m_programs.size();
+	}
+
+	//finalize() calls that reused a registered program instead of compiling
+	inline uint32_t get_hits() const {
+		return m_hits;
+	}
+};
+
+/*
+	Scanned declarations per (stage,source,define set).Instances sharing one scan each permutation of a
+	source only once,later load() calls of it copy the cached tables.
+*/
+class jglsl_reflection_cache_c {
+	friend class jglsl_shader_c;
+
+	private:
+	std::map<uint64_t,jglsl_scan_result_t> m_results;
+	uint32_t m_hits;
+
+	public:
+	jglsl_reflection_cache_c() : m_hits(0) {}
+
+	inline uint32_t get_entry_count() const {
+		return m_results.size();
+	}
+
+	//load() calls that reused a cached scan
+	inline uint32_t get_hits() const {
+		return m_hits;
+	}
+
+	void clear() {
+		m_results.clear();
+	}
+};
+
+/*
+	Stage scanned ahead by jglsl_shader_c::prepare() (on any thread),committed by commit() on the GL thread.
+	Holds its own copy of the source.
+*/
+struct jglsl_prepared_stage_t {
+	GLenum type;
+	std::string code;
+	jglsl_define_set_t defines;
+	jglsl_scan_result_t reflection;
+
+	jglsl_prepared_stage_t() : type(0) {}
+};
+
+/*
+	Builtin type names known to the scanner,classified once per token : exact names through a perfect
+	hash (hash and displace,one probe),complex ones (vec,mat,sampler...) match anywhere inside a token
+	(ivec3,dmat4,usampler2D) through a trie of the patterns.Tables are rebuilt by every add().
+*/
+class jglsl_builtin_types_t {
+	private:
+	struct node_t {
+		uint32_t child;		//First child,0 : none (the root is never a child)
+		uint32_t next;		//Next sibling,0 : none
+		char c;
+		bool terminal;		//A pattern ends here
+	};
+
+	std::vector<std::string> m_exact;
+	std::vector<std::string> m_complex;
+
+	std::vector<uint32_t> m_slots;		//Exact name index + 1,0 : empty
+	std::vector<uint32_t> m_displace;	//Per bucket,chosen so every exact name gets its own slot
+	uint32_t m_mask;
+	uint32_t m_bucket_mask;
+	uint64_t m_lengths;					//Bit n : an exact name of length n (63 : 63 or more)
+	bool m_linear;						//No perfect hash found (32bit hash collision)
+
+	std::vector<node_t> m_nodes;		//Trie of the complex patterns,node 0 is the root
+	uint32_t m_first[8];				//Bitmap of the characters complex patterns start with
+
+	static inline uint32_t slot_of(const uint32_t h,const uint32_t displace) {
+		const uint32_t x = (h ^ (displace * 0x9E3779B9u)) * 0x85EBCA6Bu;
+		return x ^ (x >> 16);
+	}
+
+	static inline uint32_t length_bit(const uint32_t len) {
+		return (len < 63) ? len : 63;
+	}
+
+	struct bucket_order_t {
+		const std::vector<uint32_t>& hashes;
+		const std::vector<uint32_t>& sizes;
+		const uint32_t mask;
+
+		bucket_order_t(const std::vector<uint32_t>& h,const std::vector<uint32_t>& s,const uint32_t m) : hashes(h),sizes(s),mask(m) {}
+
+		inline bool operator()(const uint32_t a,const uint32_t b) const {
+			const uint32_t ba = hashes[a] & mask,bb = hashes[b] & mask;
+			return (sizes[ba] != sizes[bb]) ? (sizes[ba] > sizes[bb]) : (ba < bb);
+		}
+	};
+
+	/*
+		Names are grouped in buckets by hash,the largest buckets are placed first : each gets the first
+		displacement that sends all its names to free slots.The table doubles if one cannot be placed,
+		names with equal hashes leave it to a linear search.
+	*/
+	void build_exact() {
+		const uint32_t n = m_exact.size();
+		std::vector<uint32_t> hashes(n);
+		m_lengths = 0;
+		for (uint32_t i = 0;i < n;++i) {
+			hashes[i] = jglsl_fnv1a_rt(m_exact[i].c_str(),m_exact[i].length());
+			m_lengths |= 1ull << length_bit(m_exact[i].length());
+		}
+
+		uint32_t size = 4;
+		while (size < (n * 2))
+			size <<= 1;
+
+		std::vector<uint32_t> order(n),placed;
+		m_linear = false;
+		for (;;size <<= 1) {
+			if (size > (1u << 20)) {
+				m_linear = true;
+				return;
+			}
+
+			m_mask = size - 1;
+			m_bucket_mask = (size / 4) - 1;
+			m_slots.assign(size,0);
+			m_displace.assign(size / 4,0);
+
+			//Names sorted by bucket,largest buckets first
+			std::vector<uint32_t> bucket_sizes(size / 4,0);
+			for (uint32_t i = 0;i < n;++i)
+				++bucket_sizes[hashes[i] & m_bucket_mask];
+			for (uint32_t i = 0;i < n;++i)
+				order[i] = i;
+			std::sort(order.begin(),order.end(),bucket_order_t(hashes,bucket_sizes,m_bucket_mask));
+
+			uint32_t i = 0;
+			while (i < n) {
+				const uint32_t bucket = hashes[order[i]] & m_bucket_mask;
+				uint32_t end = i;
+				while ((end < n) && ((hashes[order[end]] & m_bucket_mask) == bucket))
+					++end;
+
+				uint32_t d = 1;
+				for (;d < 4096;++d) {
+					placed.clear();
+					for (uint32_t k = i;k < end;++k) {
+						const uint32_t slot = slot_of(hashes[order[k]],d) & m_mask;
+						if ((m_slots[slot] != 0) || (std::find(placed.begin(),placed.end(),slot) != placed.end()))
+							break;
+						placed.push_back(slot);
+					}
+					if (placed.size() == (end - i))
+						break;
+				}
+				if (d == 4096)
+					break;
+
+				m_displace[bucket] = d;
+				for (uint32_t k = i;k < end;++k)
+					m_slots[placed[k - i]] = order[k] + 1;
+				i = end;
+			}
+			if (i == n)
+				return;
+		}
+	}
+
+	void build_complex() {
+		node_t root = { 0,0,0,false };
+		m_nodes.assign(1,root);
+		memset(m_first,0,sizeof(m_first));
+
+		for (uint32_t i = 0,j = m_complex.size();i < j;++i) {
+			const std::string& p = m_complex[i];
+			if (p.empty())
+				continue;
+
+			m_first[(uint8_t)p[0] >> 5] |= 1u << ((uint8_t)p[0] & 31);
+			uint32_t node = 0;
+			for (uint32_t k = 0,l = p.length();k < l;++k) {
+				uint32_t c = m_nodes[node].child;
+				while ((c != 0) && (m_nodes[c].c != p[k]))
+					c = m_nodes[c].next;
+
+				if (c == 0) {
+					node_t n = { 0,m_nodes[node].child,p[k],false };
+					c = m_nodes.size();
+					m_nodes[node].child = c;
+					m_nodes.push_back(n);
+				}
+				node = c;
+			}
+			m_nodes[node].terminal = true;
+		}
+	}
+
+	//A complex pattern at the start of s
+	inline bool match_at(const char* s,const uint32_t len) const {
+		uint32_t node = 0;
+		for (uint32_t k = 0;k < len;++k) {
+			uint32_t c = m_nodes[node].child;
+			while ((c != 0) && (m_nodes[c].c != s[k]))
+				c = m_nodes[c].next;
+			if (c == 0)
+				return false;
+			if (m_nodes[c].terminal)
+				return true;
+			node = c;
+		}
+		return false;
+	}
+
+	public:
+	jglsl_builtin_types_t() {
+		clear();
+	}
+
+	void clear() {
+		m_exact.clear();
+		m_complex.clear();
+		build_exact();
+		build_complex();
+	}
+
+	//complex : matches any token containing type
+	void add(const std::string& type,const bool complex) {
+		std::vector<std::string>& names = complex ? m_complex : m_exact;
+		if (std::find(names.begin(),names.end(),type) != names.end())
+			return;
+
+		names.push_back(type);
+		if (complex)
+			build_complex();
+		else
+			build_exact();
+	}
+
+	inline bool match(const jglsl_span_t& s) const {
+		if (m_linear) {
+			for (uint32_t i = 0,j = m_exact.size();i < j;++i) {
+				if ((m_exact[i].length() == s.len) && (memcmp(m_exact[i].c_str(),s.ptr,s.len) == 0))
+					return true;
+			}
+		} else if ((m_lengths >> length_bit(s.len)) & 1) {
+			const uint32_t h = jglsl_fnv1a_rt(s.ptr,s.len);
+			const uint32_t e = m_slots[slot_of(h,m_displace[h & m_bucket_mask]) & m_mask];
+			if ((e != 0) && (m_exact[e - 1].length() == s.len) && (memcmp(m_exact[e - 1].c_str(),s.ptr,s.len) == 0))
+				return true;
+		}
+
+		for (uint32_t k = 0;k < s.len;++k) {
+			const uint8_t c = (uint8_t)s.ptr[k];
+			if (((m_first[c >> 5] >> (c & 31)) & 1) && match_at(s.ptr + k,s.len - k))
+				return true;
+		}
+		return false;
+	}
+
+	inline const std::vector<std::string>& get_exact() const {
+		return m_exact;
+	}
+
+	inline const std::vector<std::string>& get_complex() const {
+		return m_complex;
+	}
+};
+
+/*Define it to remove all glUniform##() macros*/
+#undef JGLSL_NO_GLUNIFORM_MACROS
+/*
+	Example usage :
+
+	jglsl_shader_c* shader = new jglsl_shader_c();
+	
+    char* v_shader = read_nullterm_text_file("shaders/test.vert");
+    char* f_shader = read_nullterm_text_file("shaders/test.frag");
+    shader->load(GL_FRAGMENT_SHADER,f_shader,strlen(f_shader));
+    shader->load(GL_VERTEX_SHADER,v_shader,strlen(v_shader));
+    delete v_shader; delete f_shader;
+
+
+	shader->finalize(); 	//Will link shaders & resolve all symbol addresses
+
+	if (shader->get_log())
+		printf("Log : %s\n",shader->get_log());
+
+	//Non blocking alternative (GL_KHR_parallel_shader_compile) :
+	shader->load_async(GL_FRAGMENT_SHADER,f_shader,strlen(f_shader));
+	shader->load_async(GL_VERTEX_SHADER,v_shader,strlen(v_shader));
+	shader->finalize_async();
+	...
+	if (shader->poll() && shader->is_linked()) //Once per frame until it returns true
+		...
+
+	uint32_t some_attr_location = shader->get_attribute("a_var");
+	const std::vector<jglsl_vertex_attrib_t>& inputs = shader->get_vertex_layout(); //"attribute" and vertex "in" declarations
+	uint32_t some_uni_location = shader->get_uniform("u_var");
+
+
+	//Structure access :
+	glsl shader :
+	struct var3_t { int a2; int b2; int c2; }
+	struct var_t { int a; int b; int c; var3_t f; }
+	struct var2_t {var_t other; int d; int e; }
+
+	uniform var2_t test;
+	...
+
+
+	To access test.other.a; do :
+	uint32_t some_uni_location = shader->get_uniform("test.other.a");
+
+	To access test.other.f.a2; do :
+	uint32_t some_uni_location = shader->get_uniform("test.other.f.a2");
+
+	To access test.e; do :
+	uint32_t some_uni_location = shader->get_uniform("test.e");
+
+	To modify location by name do :
+	shader->u_s32("test.other.f.a2",0);
+	shader->u_s32(JGLSL_U("test.other.f.a2"),0); //Same,hash guaranteed to be computed at compile time
+
+	To modify location by index do :
+	shader->u_s32(some_uni_location,0);
+
+	Arrays (sizes may use global int/uint constants) :
+	const int N = 4;
+	uniform mat4 bones[N * 16];
+	uniform var_t lights[N];
+
+	shader->u_mat4_fv("bones",64,palette);		//Whole array in one call
+	shader->u_mat4_fv("bones[8]",1,palette + 128);
+	shader->u_s32("lights[2].f.a2",0);
+	jglsl_uniform_array_t a = shader->get_uniform_array("lights[0].f.a2"); //a.location + k * a.stride
+
+	Explicit layout(location = N) / layout(binding = N) qualifiers are taken from the sources,
+	declarations that all carry one link without any location query.
+
+	Texture units :
+	uniform sampler2D u_albedo;						//Lowest free unit
+	layout(binding = 4) uniform sampler2D u_shadow;	//Unit 4 (GL 4.2)
+
+	shader->finalize();								//Sets every sampler/image uniform to its unit once
+	shader->bind_texture("u_albedo",GL_TEXTURE_2D,tex);	//glActiveTexture(GL_TEXTURE0 + unit) + glBindTexture
+	const uint32_t unit = shader->get_texture_unit("u_albedo");
+
+	Bindless (jglsl_gl_caps().bindless_texture,sampler uniforms declared with layout(bindless_sampler)) :
+	const GLuint64 handle = jglsl_resident_texture_handle(tex);	//Once
+	shader->u_tex_handle("u_albedo",handle);		//No texture binds per draw
+
+	Uniforms set once per session as constants (hot reload on,stages declare "uniform int u_quality;") :
+	shader->specialize("u_quality",2);
+	shader->commit_specializations();				//Builds the variant in the background
+	For every frame :
+		shader->poll();								//Swaps it in once linked
+
+	To update without binding first (GL 4.1) :
+	shader->set_direct_state_access(true);
+	shader->u_s32(some_uni_location,0);
+
+	Profiling (JGLSL_PROFILE defined before the include) :
+	jglsl_set_gpu_timers(true);
+	For every frame :
+		...draws...
+		jglsl_profile_end_frame();
+	const jglsl_profile_stats_t& st = shader->get_stats(); //st.cpu[JGLSL_PHASE_FINALIZE].ns,st.frame_uniform_calls,st.gpu_ns
+
+	Many programs at once (links overlap instead of waiting on each one) :
+	jglsl_finalize_stats_t st;
+	jglsl_shader_c::finalize_all(shaders,&st);		//std::vector<jglsl_shader_c*>,st.failed,st.collect_ns
+
+	By value (movable,not copyable) :
+	std::vector<jglsl_shader_c> programs(count);
+	programs[i].load(GL_VERTEX_SHADER,vs_code);
+	...
+	std::sort(programs.begin(),programs.end(),by_state); //Moves never touch GL
+*/
+
+class jglsl_shader_c {
+	private:
+	typedef jglsl_scan_result_t scan_result_t;
+	typedef jglsl_name_table_t::slot_t uniform_slot_t;
+	typedef jglsl_uniform_state_t uniform_state_t;
+
+	//Shared table of the standard types until register_builtin_type() makes a private copy
+	const jglsl_builtin_types_t* m_builtin_types;
+	jglsl_builtin_types_t* m_own_builtin_types;
+
+	scan_result_t m_pending;
+	bool m_precomputed;		//m_pending came from set_precomputed_reflection(),load() does not parse
+	std::vector<GLuint> m_shaders;
+	std::vector<char> m_log_buffer;
+
+	//Linked program with its location tables and shadow state (jglsl_program_t::null_program() when there is none)
+	jglsl_program_t* m_prog;
+	jglsl_program_registry_c* m_registry;
+	jglsl_reflection_cache_c* m_reflection_cache;
+
+	//Shadow copy of the last value sent to GL for every reflected uniform
+	enum {
+		JGLSL_UK_1F = 0,JGLSL_UK_2F,JGLSL_UK_3F,JGLSL_UK_4F,
+		JGLSL_UK_1D,JGLSL_UK_2D,JGLSL_UK_3D,JGLSL_UK_4D,
+		JGLSL_UK_MAT3F,JGLSL_UK_MAT4F,JGLSL_UK_MAT3D,JGLSL_UK_MAT4D,
+		JGLSL_UK_1I,JGLSL_UK_1UI,
+		JGLSL_UK_HANDLE		//Bindless texture handle,never shadowed
+	};
+
+	mutable uint32_t m_uniform_calls_issued;
+	mutable uint32_t m_uniform_calls_skipped;
+
+	//Batched mode : the shadow block doubles as staging area,flush() sends whatever is marked dirty
+	bool m_batched;
+	bool m_dsa;		//Immediate setters go through glProgramUniform*
+	bool m_dsa_requested;	//set_direct_state_access() setting,m_dsa is also forced on by separable mode
+
+	//Instrumentation (see jglsl_profile_stats_t)
+	mutable jglsl_profile_stats_t m_stats;
+#ifdef JGLSL_PROFILE
+	uint32_t m_frame_calls_mark;			//m_uniform_calls_issued when the current frame started
+	uint32_t m_frame_binds;
+	std::vector<GLuint> m_gpu_queries[2];	//Span queries by frame parity,results are read a frame later
+	uint32_t m_gpu_used[2];
+
+	void begin_gpu_span() {
+		++m_frame_binds;
+		jglsl_profile_state_t& state = jglsl_profile_state();
+		if ((!state.gpu_timers) || (state.active_owner == this))
+			return;
+
+		jglsl_end_gpu_span();
+		const uint32_t slot = state.frame & 1;
+		if (m_gpu_used[slot] == m_gpu_queries[slot].size()) {
+			GLuint query = 0;
+			glGenQueries(1,&query);
+			m_gpu_queries[slot].push_back(query);
+		}
+
+		state.active_query = m_gpu_queries[slot][m_gpu_used[slot]++];
+		state.active_owner = this;
+		glBeginQuery(GL_TIME_ELAPSED,state.active_query);
+	}
+#endif
+
+	static uint32_t kind_size(const uint32_t kind) {
+		static const uint32_t sizes[] = { 4,8,12,16, 8,16,24,32, 36,64,72,128, 4,4, 8 };
+		return sizes[kind];
+	}
+
+	//Size in bytes of a builtin GLSL type as passed to glUniform*,0 if it is not a plain value type
+	static uint32_t glsl_type_size(const std::string& type) {
+		if ((type == "float") || (type == "int") || (type == "uint") || (type == "bool") || (type == "atomic_uint"))
+			return 4;
+		else if (type == "double")
+			return 8;
+		else if ((type.find("sampler") != std::string::npos) || (type.find("image") != std::string::npos))
+			return 4;
+
+		const char* p = type.c_str();
+		uint32_t scalar = 4;
+		if (*p == 'd') {
+			scalar = 8;
+			++p;
+		} else if ((*p == 'i') || (*p == 'u') || (*p == 'b')) {
+			++p;
+		}
+
+		if ((strncmp(p,"vec",3) == 0) && (p[3] >= '2') && (p[3] <= '4') && (p[4] == 0))
+			return scalar * (p[3] - '0');
+
+		if ((strncmp(p,"mat",3) == 0) && (p[3] >= '2') && (p[3] <= '4')) {
+			const uint32_t c = p[3] - '0';
+			if (p[4] == 0)
+				return scalar * c * c;
+			if ((p[4] == 'x') && (p[5] >= '2') && (p[5] <= '4') && (p[6] == 0))
+				return scalar * c * (p[5] - '0');
+		}
+
+		return 0;
+	}
+
+	//GLSL name of a GL_TYPE value (empty : not a type the shadow copies size)
+	static const char* gl_type_name(const GLenum type) {
+		static const struct { GLenum type; const char* name; } types[] = {
+			{ GL_FLOAT,"float" },{ GL_FLOAT_VEC2,"vec2" },{ GL_FLOAT_VEC3,"vec3" },{ GL_FLOAT_VEC4,"vec4" },
+			{ GL_DOUBLE,"double" },{ GL_DOUBLE_VEC2,"dvec2" },{ GL_DOUBLE_VEC3,"dvec3" },{ GL_DOUBLE_VEC4,"dvec4" },
+			{ GL_INT,"int" },{ GL_INT_VEC2,"ivec2" },{ GL_INT_VEC3,"ivec3" },{ GL_INT_VEC4,"ivec4" },
+			{ GL_UNSIGNED_INT,"uint" },{ GL_UNSIGNED_INT_VEC2,"uvec2" },{ GL_UNSIGNED_INT_VEC3,"uvec3" },{ GL_UNSIGNED_INT_VEC4,"uvec4" },
+			{ GL_BOOL,"bool" },{ GL_BOOL_VEC2,"bvec2" },{ GL_BOOL_VEC3,"bvec3" },{ GL_BOOL_VEC4,"bvec4" },
+			{ GL_FLOAT_MAT2,"mat2" },{ GL_FLOAT_MAT3,"mat3" },{ GL_FLOAT_MAT4,"mat4" },
+			{ GL_FLOAT_MAT2x3,"mat2x3" },{ GL_FLOAT_MAT2x4,"mat2x4" },{ GL_FLOAT_MAT3x2,"mat3x2" },
+			{ GL_FLOAT_MAT3x4,"mat3x4" },{ GL_FLOAT_MAT4x2,"mat4x2" },{ GL_FLOAT_MAT4x3,"mat4x3" },
+			{ GL_DOUBLE_MAT2,"dmat2" },{ GL_DOUBLE_MAT3,"dmat3" },{ GL_DOUBLE_MAT4,"dmat4" },
+			{ GL_DOUBLE_MAT2x3,"dmat2x3" },{ GL_DOUBLE_MAT2x4,"dmat2x4" },{ GL_DOUBLE_MAT3x2,"dmat3x2" },
+			{ GL_DOUBLE_MAT3x4,"dmat3x4" },{ GL_DOUBLE_MAT4x2,"dmat4x2" },{ GL_DOUBLE_MAT4x3,"dmat4x3" }
+		};
+
+		for (uint32_t i = 0;i < sizeof(types) / sizeof(types[0]);++i) {
+			if (types[i].type == type)
+				return types[i].name;
+		}
+		return "";
+	}
+
+	static void gl_uniform(const uint32_t kind,const GLint loc,const GLsizei cnt,const void* data) {
+		switch (kind) {
+			case JGLSL_UK_1F:		glUniform1fv(loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_2F:		glUniform2fv(loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_3F:		glUniform3fv(loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_4F:		glUniform4fv(loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_1D:		glUniform1dv(loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_2D:		glUniform2dv(loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_3D:		glUniform3dv(loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_4D:		glUniform4dv(loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_MAT3F:	glUniformMatrix3fv(loc,cnt,GL_FALSE,(const GLfloat*)data); break;
+			case JGLSL_UK_MAT4F:	glUniformMatrix4fv(loc,cnt,GL_FALSE,(const GLfloat*)data); break;
+			case JGLSL_UK_MAT3D:	glUniformMatrix3dv(loc,cnt,GL_FALSE,(const GLdouble*)data); break;
+			case JGLSL_UK_MAT4D:	glUniformMatrix4dv(loc,cnt,GL_FALSE,(const GLdouble*)data); break;
+			case JGLSL_UK_1I:		glUniform1iv(loc,cnt,(const GLint*)data); break;
+			case JGLSL_UK_1UI:		glUniform1uiv(loc,cnt,(const GLuint*)data); break;
+#ifdef GL_ARB_bindless_texture
+			case JGLSL_UK_HANDLE:	glUniformHandleui64vARB(loc,cnt,(const GLuint64*)data); break;
+#endif
+		}
+	}
+
+	static void gl_program_uniform(const uint32_t kind,const GLuint prog,const GLint loc,const GLsizei cnt,const void* data) {
+		switch (kind) {
+			case JGLSL_UK_1F:		glProgramUniform1fv(prog,loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_2F:		glProgramUniform2fv(prog,loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_3F:		glProgramUniform3fv(prog,loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_4F:		glProgramUniform4fv(prog,loc,cnt,(const GLfloat*)data); break;
+			case JGLSL_UK_1D:		glProgramUniform1dv(prog,loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_2D:		glProgramUniform2dv(prog,loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_3D:		glProgramUniform3dv(prog,loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_4D:		glProgramUniform4dv(prog,loc,cnt,(const GLdouble*)data); break;
+			case JGLSL_UK_MAT3F:	glProgramUniformMatrix3fv(prog,loc,cnt,GL_FALSE,(const GLfloat*)data); break;
+			case JGLSL_UK_MAT4F:	glProgramUniformMatrix4fv(prog,loc,cnt,GL_FALSE,(const GLfloat*)data); break;
+			case JGLSL_UK_MAT3D:	glProgramUniformMatrix3dv(prog,loc,cnt,GL_FALSE,(const GLdouble*)data); break;
+			case JGLSL_UK_MAT4D:	glProgramUniformMatrix4dv(prog,loc,cnt,GL_FALSE,(const GLdouble*)data); break;
+			case JGLSL_UK_1I:		glProgramUniform1iv(prog,loc,cnt,(const GLint*)data); break;
+			case JGLSL_UK_1UI:		glProgramUniform1uiv(prog,loc,cnt,(const GLuint*)data); break;
+#ifdef GL_ARB_bindless_texture
+			case JGLSL_UK_HANDLE:	glProgramUniformHandleui64vARB(prog,loc,cnt,(const GLuint64*)data); break;
+#endif
+		}
+	}
+
+	//All setters end up here : compare against the shadow copy and only call GL on a change
+	void set_uniform(const uint32_t kind,const uint32_t location,const uint32_t cnt,const void* data) const {
+		const uint32_t bytes = kind_size(kind) * cnt;
+
+		if (location == 0xFFFFFFFFu) { //Inactive uniform,GL would ignore it anyway
+			++m_uniform_calls_skipped;
+			return;
+		}
+
+		if ((location < m_prog->location_states.size()) && (m_prog->location_states[location] != 0)) {
+			const uint32_t idx = m_prog->location_states[location] - 1;
+			uniform_state_t& st = m_prog->uniform_states[idx];
+			const uint32_t start = (location - st.location) * (st.size / st.count);	//Writes may start at any element
+
+			//Handles do not fit the slot of an opaque uniform (sized as its unit)
+			if (((start + bytes) <= st.size) && (kind != JGLSL_UK_HANDLE)) {
+				uint8_t* shadow = &m_prog->uniform_shadow[st.offset + start];
+
+				if (((start + bytes) <= st.bytes) && (memcmp(shadow,data,bytes) == 0)) {
+					++m_uniform_calls_skipped;
+					return;
+				}
+
+				memcpy(shadow,data,bytes);
+				st.kind = kind;
+				if (start <= st.bytes)
+					st.bytes = std::max(st.bytes,start + bytes);
+
+				if (m_batched) {
+					stage_range(idx,start,start + bytes);
+					return;
+				}
+			} else {
+				if (st.dirty) {	//Staged elements go out first,the write below overrides them
+					const GLuint prev = begin_uniform_setup();
+					send_staged(st);
+					end_uniform_setup(prev);
+				}
+				st.bytes = 0;
+			}
+		}
+
+		++m_uniform_calls_issued;
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_UPLOADS);
+		if (m_dsa || (m_batched && jglsl_gl_caps().program_uniform)) {
+			gl_program_uniform(kind,m_prog->id,(GLint)location,(GLsizei)cnt,data);
+		} else if (m_batched) {	//Batched setters may run while another program is bound
+			const GLuint prev = begin_uniform_setup();
+			gl_uniform(kind,(GLint)location,(GLsizei)cnt,data);
+			end_uniform_setup(prev);
+		} else {
+			gl_uniform(kind,(GLint)location,(GLsizei)cnt,data);
+		}
+	}
+
+	/*
+		Adds [begin,end) (bytes into the slot of state idx) to its staged range.
+		The range is only widened over values known to GL,otherwise the staged elements are sent first.
+	*/
+	void stage_range(const uint32_t idx,const uint32_t begin,const uint32_t end) const {
+		uniform_state_t& st = m_prog->uniform_states[idx];
+
+		if (st.dirty) {
+			const uint32_t gap_end = (begin > st.dirty_end) ? begin : ((end < st.dirty_begin) ? st.dirty_begin : 0);
+			if (gap_end <= st.bytes) {
+				st.dirty_begin = std::min(st.dirty_begin,begin);
+				st.dirty_end = std::max(st.dirty_end,end);
+				return;
+			}
+
+			const GLuint prev = begin_uniform_setup();
+			send_staged(st);
+			end_uniform_setup(prev);
+		}
+
+		st.dirty = 1;
+		st.dirty_begin = begin;
+		st.dirty_end = end;
+		m_prog->dirty_states.push_back(idx);
+	}
+
+	//One call for the staged range of st,glUniform* needs this program bound
+	void send_staged(uniform_state_t& st) const {
+		const GLint location = st.location + st.dirty_begin / (st.size / st.count);
+		const GLsizei cnt = (st.dirty_end - st.dirty_begin) / kind_size(st.kind);
+		const void* data = &m_prog->uniform_shadow[st.offset + st.dirty_begin];
+		st.dirty = 0;
+		if (st.dirty_begin <= st.bytes)	//Values staged before invalidate_uniform_cache() are known again
+			st.bytes = std::max(st.bytes,st.dirty_end);
+
+		++m_uniform_calls_issued;
+		if (jglsl_gl_caps().program_uniform)
+			gl_program_uniform(st.kind,m_prog->id,location,cnt,data);
+		else
+			gl_uniform(st.kind,location,cnt,data);
+	}
+
+	//count : elements at consecutive locations
+	void add_uniform_state(const uint32_t location,const std::string& type,const uint32_t count) {
+		if (location == 0xFFFFFFFFu)
+			return;
+
+		uniform_state_t st;
+		st.offset = m_prog->uniform_shadow.size();
+		st.size = glsl_type_size(type) * count;
+		st.bytes = 0;
+		st.location = location;
+		st.count = count;
+		st.kind = 0;
+		st.dirty = 0;
+		st.dirty_begin = 0;
+		st.dirty_end = 0;
+		m_prog->uniform_shadow.resize(st.offset + st.size);
+		m_prog->uniform_states.push_back(st);
+
+		if ((location + count) > m_prog->location_states.size())
+			m_prog->location_states.resize(location + count,0);
+		for (uint32_t i = 0;i < count;++i)
+			m_prog->location_states[location + i] = m_prog->uniform_states.size();
+	}
+
+	//Active size of an array uniform whose declared size could not be evaluated
+	uint32_t query_array_size(const std::string& uni) const {
+		GLint n = 0;
+		glGetProgramiv(m_prog->id,GL_ACTIVE_UNIFORMS,&n);
+
+		const std::string first = uni + "[0]";
+		for (GLint i = 0;i < n;++i) {
+			char name[256];
+			GLsizei len = 0;
+			GLint size = 0;
+			GLenum type;
+
+			glGetActiveUniform(m_prog->id,i,sizeof(name),&len,&size,&type,name);
+			if ((std::string(name,len) == uni) || (std::string(name,len) == first))
+				return (uint32_t)size;
+		}
+		return 1;
+	}
+
+	//On a table miss : "name[k]" of a reflected array of a basic type is its base location + k
+	uint32_t find_element(const char* uni) const {
+		const uint32_t len = strlen(uni);
+		if ((len < 4) || (uni[len - 1] != ']'))
+			return 0;
+
+		uint32_t b = len - 2;
+		while ((b > 0) && isdigit((unsigned char)uni[b]))
+			--b;
+		if ((uni[b] != '[') || (b == (len - 2)))
+			return 0;
+
+		const uint32_t* location = m_prog->uniforms.find(uni,b);
+		if ((!location) || (*location >= m_prog->location_states.size()) || (m_prog->location_states[*location] == 0))
+			return 0;
+
+		const uint32_t k = strtoul(&uni[b + 1],0,10);
+		return (k < m_prog->uniform_states[m_prog->location_states[*location] - 1].count) ? *location + k : 0;
+	}
+
+	void clear_uniform_states() {
+		m_prog->dirty_states.clear();
+		m_prog->uniform_states.clear();
+		m_prog->uniform_shadow.clear();
+		m_prog->location_states.clear();
+	}
+
+	//Program binary cache : with a cache directory (or a registry) set,load() only records the sources and
+	//finalize() either reuses a registered program,restores it from disk or compiles/links/stores it
+	struct deferred_source_t {
+		GLenum type;
+		jglsl_span_t code;	//Caller's buffer when sources are persistent
+		std::string owned;	//Private copy otherwise
+		jglsl_define_set_t defines;
+		bool prepared;		//reflection came from prepare(),the source is not scanned again
+		jglsl_scan_result_t reflection;
+
+		inline jglsl_span_t data() const {
+			if (code.ptr != 0)
+				return code;
+
+			jglsl_span_t s;
+			s.ptr = owned.c_str();
+			s.len = owned.length();
+			return s;
+		}
+	};
+	std::string m_cache_dir;
+	bool m_persistent_sources;
+	std::vector<deferred_source_t> m_deferred;
+
+	//Hot reload : stages stay compiled along with their source and reflection (see set_hot_reload())
+	struct kept_stage_t {
+		GLenum type;
+		GLuint shader;
+		std::string code;
+		jglsl_define_set_t defines;
+		uint64_t decl_hash;		//declaration_hash() of the source
+		jglsl_scan_result_t reflection;
+	};
+	bool m_hot_reload;
+	std::vector<kept_stage_t> m_stages;			//Of the current program,owns the shaders
+	std::vector<kept_stage_t> m_loaded_stages;	//Loaded since the last finalize(),shaders are in m_shaders
+
+	//Uniforms turned into constants by specialize(),value is the GLSL literal
+	struct specialization_t {
+		std::string name;
+		std::string value;
+	};
+	std::vector<specialization_t> m_specializations;
+	jglsl_program_t* m_specialized;		//Variant linking in the background,swapped in by poll() (0 : none)
+
+	//Buffers attached with set_storage_buffer(),bindings are looked up again after every link
+	struct storage_buffer_t {
+		std::string block;
+		uint32_t binding;		//jglsl_invalid_offset : block not in the current program
+		GLuint buffer;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+	std::vector<storage_buffer_t> m_storage_buffers;
+
+	//Indirection table of get_uniform_handle(),locations are updated by every link
+	std::vector<std::string> m_handle_names;
+	std::vector<uint32_t> m_handle_locations;
+	uint64_t m_handles_serial;	//Program (serial and link count) the handles and storage bindings were resolved against
+	uint32_t m_handles_links;
+	uint64_t m_source_hash;		//All sources given to load() since the last finalize()
+	GLbitfield m_stage_bits;	//Stages given to load() since the last finalize()
+	bool m_separable;
+
+	static const uint32_t cache_magic = 0x4250474Au;	//"JGPB"
+	static const uint32_t cache_version = 5;
+
+	//Kept stages are compiled by this instance,hot reload bypasses the registry and the binary cache
+	inline bool use_binary_cache() const {
+		return (!m_hot_reload) && (!m_cache_dir.empty()) && jglsl_gl_caps().program_binary;
+	}
+
+	inline bool use_registry() const {
+		return (!m_hot_reload) && (m_registry != 0);
+	}
+
+	inline bool defer_sources() const {
+		return use_registry() || use_binary_cache();
+	}
+
+	static uint64_t stage_hash(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines,
+					uint64_t h) {
+		h = jglsl_fnv1a64(&type,sizeof(type),h);
+		h = jglsl_fnv1a64(&len,sizeof(len),h);
+		h = jglsl_fnv1a64(code,len,h);
+		return defines.hash(h);
+	}
+
+	//Permutations of a source hash apart,so registry and binary cache entries are per define set
+	void hash_source(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines) {
+		m_source_hash = stage_hash(type,code,len,defines,m_source_hash);
+		m_stage_bits |= stage_bit(type);
+	}
+
+	static GLbitfield stage_bit(const GLenum type) {
+		switch (type) {
+			case GL_VERTEX_SHADER:			return GL_VERTEX_SHADER_BIT;
+			case GL_FRAGMENT_SHADER:		return GL_FRAGMENT_SHADER_BIT;
+			case GL_GEOMETRY_SHADER:		return GL_GEOMETRY_SHADER_BIT;
+			case GL_TESS_CONTROL_SHADER:	return GL_TESS_CONTROL_SHADER_BIT;
+			case GL_TESS_EVALUATION_SHADER:	return GL_TESS_EVALUATION_SHADER_BIT;
+			case GL_COMPUTE_SHADER:			return GL_COMPUTE_SHADER_BIT;
+		}
+		return 0;
+	}
+
+	std::string cache_path(const uint64_t source_hash) const {
+		char name[32];
+		const uint64_t key = jglsl_fnv1a64(&jglsl_gl_caps().driver_hash,sizeof(uint64_t),source_hash);
+		sprintf(name,"%016llx.jglslbin",(unsigned long long)key);
+
+		std::string path = m_cache_dir;
+		if ((!path.empty()) && (path[path.size() - 1] != '/') && (path[path.size() - 1] != '\\'))
+			path += '/';
+		return path + name;
+	}
+
+	static void put_u32(std::vector<uint8_t>& out,const uint32_t v) {
+		const uint8_t b[4] = { (uint8_t)v,(uint8_t)(v >> 8),(uint8_t)(v >> 16),(uint8_t)(v >> 24) };
+		out.insert(out.end(),b,b + 4);
+	}
+
+	static void put_str(std::vector<uint8_t>& out,const std::string& str) {
+		put_u32(out,str.length());
+		out.insert(out.end(),str.begin(),str.end());
+	}
+
+	static bool get_u32(const uint8_t* data,const uint32_t len,uint32_t& offs,uint32_t& v) {
+		if ((len < 4) || (offs > (len - 4)))
+			return false;
+		v = data[offs] | (data[offs + 1] << 8) | (data[offs + 2] << 16) | ((uint32_t)data[offs + 3] << 24);
+		offs += 4;
+		return true;
+	}
+
+	static bool get_str(const uint8_t* data,const uint32_t len,uint32_t& offs,std::string& str) {
+		uint32_t n;
+		if ((!get_u32(data,len,offs,n)) || (n > (len - offs)))
+			return false;
+		str.assign((const char*)&data[offs],n);
+		offs += n;
+		return true;
+	}
+
+	//Parsed name tables (uniforms/attributes with their types,then uniform blocks,uniform array sizes and layout qualifiers)
+	static void serialize_reflection(const scan_result_t& res,std::vector<uint8_t>& out) {
+		put_u32(out,res.uniforms.size());
+		for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+			put_str(out,res.uniforms[i]);
+			put_str(out,res.uniform_types[i]);
+		}
+
+		put_u32(out,res.attributes.size());
+		for (uint32_t i = 0,j = res.attributes.size();i < j;++i) {
+			put_str(out,res.attributes[i]);
+			put_str(out,res.attribute_types[i]);
+		}
+
+		put_u32(out,res.blocks.size());
+		for (uint32_t i = 0,j = res.blocks.size();i < j;++i)
+			put_block_layout(out,res.blocks[i]);
+
+		put_u32(out,res.uniform_counts.size());
+		for (uint32_t i = 0,j = res.uniform_counts.size();i < j;++i)
+			put_u32(out,res.uniform_counts[i]);
+
+		//Explicit layout qualifiers
+		for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+			put_u32(out,res.uniform_locations[i]);
+			put_u32(out,res.uniform_bindings[i]);
+		}
+		for (uint32_t i = 0,j = res.attributes.size();i < j;++i)
+			put_u32(out,res.attribute_locations[i]);
+		for (uint32_t i = 0,j = res.blocks.size();i < j;++i)
+			put_u32(out,res.blocks[i].binding);
+
+		//Compute
+		put_u32(out,res.storage_blocks.size());
+		for (uint32_t i = 0,j = res.storage_blocks.size();i < j;++i) {
+			put_block_layout(out,res.storage_blocks[i]);
+			put_u32(out,res.storage_blocks[i].binding);
+		}
+		for (uint32_t i = 0;i < 3;++i)
+			put_u32(out,res.local_size[i]);
+	}
+
+	static void put_block_layout(std::vector<uint8_t>& out,const jglsl_uniform_block_t& b) {
+		put_str(out,b.name);
+		put_str(out,b.instance);
+		put_u32(out,b.layout);
+		put_u32(out,b.size);
+		put_u32(out,b.members.size());
+
+		for (uint32_t k = 0,w = b.members.size();k < w;++k) {
+			const jglsl_block_member_t& m = b.members[k];
+			put_str(out,m.name);
+			put_str(out,m.type);
+			put_u32(out,m.offset);
+			put_u32(out,m.array_count);
+			put_u32(out,m.array_stride);
+			put_u32(out,m.matrix_stride | (m.row_major ? 0x80000000u : 0));
+		}
+	}
+
+	static bool get_block_layout(const uint8_t* data,const uint32_t len,uint32_t& offs,jglsl_uniform_block_t& b) {
+		uint32_t members;
+
+		if ((!get_str(data,len,offs,b.name)) || (!get_str(data,len,offs,b.instance)) ||
+			(!get_u32(data,len,offs,b.layout)) || (!get_u32(data,len,offs,b.size)) || (!get_u32(data,len,offs,members)))
+			return false;
+
+		b.index = GL_INVALID_INDEX;
+		b.binding = jglsl_invalid_offset;
+		for (uint32_t k = 0;k < members;++k) {
+			jglsl_block_member_t m;
+			if ((!get_str(data,len,offs,m.name)) || (!get_str(data,len,offs,m.type)) ||
+				(!get_u32(data,len,offs,m.offset)) || (!get_u32(data,len,offs,m.array_count)) ||
+				(!get_u32(data,len,offs,m.array_stride)) || (!get_u32(data,len,offs,m.matrix_stride)))
+				return false;
+
+			m.row_major = (m.matrix_stride & 0x80000000u) != 0;
+			m.matrix_stride &= 0x7FFFFFFFu;
+			b.members.push_back(m);
+		}
+		return true;
+	}
+
+	static bool deserialize_reflection(scan_result_t& res,const uint8_t* data,const uint32_t len,uint32_t& offs) {
+		std::string name,type;
+		uint32_t n;
+
+		if (!get_u32(data,len,offs,n))
+			return false;
+		for (uint32_t i = 0;i < n;++i) {
+			if ((!get_str(data,len,offs,name)) || (!get_str(data,len,offs,type)))
+				return false;
+			res.uniforms.push_back(name);
+			res.uniform_types.push_back(type);
+		}
+		res.uniform_counts.assign(res.uniforms.size(),1);
+		res.uniform_locations.assign(res.uniforms.size(),jglsl_invalid_offset);
+		res.uniform_bindings.assign(res.uniforms.size(),jglsl_invalid_offset);
+
+		if (!get_u32(data,len,offs,n))
+			return false;
+		for (uint32_t i = 0;i < n;++i) {
+			if ((!get_str(data,len,offs,name)) || (!get_str(data,len,offs,type)))
+				return false;
+			res.attributes.push_back(name);
+			res.attribute_types.push_back(type);
+		}
+		res.attribute_locations.assign(res.attributes.size(),jglsl_invalid_offset);
+
+		if (offs == len) //Written before uniform blocks were reflected
+			return true;
+
+		if (!get_u32(data,len,offs,n))
+			return false;
+		for (uint32_t i = 0;i < n;++i) {
+			jglsl_uniform_block_t b;
+			if (!get_block_layout(data,len,offs,b))
+				return false;
+			res.blocks.push_back(b);
+		}
+
+		if (offs == len) //Written before uniform arrays were reflected
+			return true;
+
+		if ((!get_u32(data,len,offs,n)) || (n != res.uniform_counts.size()))
+			return false;
+		for (uint32_t i = 0;i < n;++i) {
+			if (!get_u32(data,len,offs,res.uniform_counts[i]))
+				return false;
+		}
+
+		if (offs == len) //Written before layout qualifiers were reflected
+			return true;
+
+		for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+			if ((!get_u32(data,len,offs,res.uniform_locations[i])) || (!get_u32(data,len,offs,res.uniform_bindings[i])))
+				return false;
+		}
+		for (uint32_t i = 0,j = res.attributes.size();i < j;++i) {
+			if (!get_u32(data,len,offs,res.attribute_locations[i]))
+				return false;
+		}
+		for (uint32_t i = 0,j = res.blocks.size();i < j;++i) {
+			if (!get_u32(data,len,offs,res.blocks[i].binding))
+				return false;
+		}
+
+		if (offs == len) //Written before storage blocks were reflected
+			return true;
+
+		if (!get_u32(data,len,offs,n))
+			return false;
+		for (uint32_t i = 0;i < n;++i) {
+			jglsl_uniform_block_t b;
+			if ((!get_block_layout(data,len,offs,b)) || (!get_u32(data,len,offs,b.binding)))
+				return false;
+			res.storage_blocks.push_back(b);
+		}
+		for (uint32_t i = 0;i < 3;++i) {
+			if (!get_u32(data,len,offs,res.local_size[i]))
+				return false;
+		}
+
+		return true;
+	}
+
+	static bool read_file(const std::string& path,std::vector<uint8_t>& data) {
+		FILE* f = fopen(path.c_str(),"rb");
+		if (!f)
+			return false;
+
+		fseek(f,0,SEEK_END);
+		const long size = ftell(f);
+		fseek(f,0,SEEK_SET);
+
+		bool ret = size > 0;
+		if (ret) {
+			data.resize(size);
+			ret = fread(&data[0],1,size,f) == (size_t)size;
+		}
+
+		fclose(f);
+		return ret;
+	}
+
+	//On success leaves m_prog with a pending link and the cached name tables as its reflection
+	bool load_binary_cache(const std::string& path) {
+		std::vector<uint8_t> file;
+		if (!read_file(path,file))
+			return false;
+
+		const uint8_t* data = &file[0];
+		const uint32_t len = file.size();
+		uint32_t offs = 0,magic,version,format,bin_len;
+
+		if ((!get_u32(data,len,offs,magic)) || (magic != cache_magic))
+			return false;
+		if ((!get_u32(data,len,offs,version)) || (version != cache_version))
+			return false;
+		if ((!get_u32(data,len,offs,format)) || (!get_u32(data,len,offs,bin_len)) || (bin_len > (len - offs)))
+			return false;
+
+		const uint32_t bin_offs = offs;
+		offs += bin_len;
+
+		GLint status = GL_FALSE;
+		if (deserialize_reflection(m_prog->reflection,data,len,offs)) {
+			m_prog->id = glCreateProgram();
+			if (m_separable)
+				glProgramParameteri(m_prog->id,GL_PROGRAM_SEPARABLE,GL_TRUE);
+			glProgramBinary(m_prog->id,format,&data[bin_offs],bin_len);
+			glGetProgramiv(m_prog->id,GL_LINK_STATUS,&status);
+		}
+
+		if (status != GL_FALSE)
+			return true;
+
+		//Rejected (driver update etc) : recompile from source
+		if (m_prog->id != 0) {
+			glDeleteProgram(m_prog->id);
+			m_prog->id = 0;
+		}
+		m_prog->reflection.clear();
+		return false;
+	}
+
+	void store_binary_cache() {
+		GLint bin_len = 0;
+		glGetProgramiv(m_prog->id,GL_PROGRAM_BINARY_LENGTH,&bin_len);
+		if (bin_len <= 0)
+			return;
+
+		std::vector<uint8_t> file;
+		std::vector<uint8_t> bin(bin_len);
+		GLenum format = 0;
+		GLsizei written = 0;
+		glGetProgramBinary(m_prog->id,bin_len,&written,&format,&bin[0]);
+		if (written <= 0)
+			return;
+
+		put_u32(file,cache_magic);
+		put_u32(file,cache_version);
+		put_u32(file,format);
+		put_u32(file,written);
+		file.insert(file.end(),bin.begin(),bin.begin() + written);
+		serialize_reflection(m_prog->reflection,file);
+
+		//Write aside and rename so a concurrent reader never sees a partial file
+		const std::string& path = m_prog->binary_path;
+		const std::string tmp = path + ".tmp";
+		FILE* f = fopen(tmp.c_str(),"wb");
+		if (!f)
+			return;
+
+		const bool ok = fwrite(&file[0],1,file.size(),f) == file.size();
+		fclose(f);
+		if ((!ok) || (rename(tmp.c_str(),path.c_str()) != 0))
+			remove(tmp.c_str());
+	}
+
+	//Compiled through load_async(),status not queried yet (moved to the program by finalize())
+	std::vector<GLuint> m_unchecked_shaders;
+
+	//Keeps the buffer NUL terminated for get_log()
+	void append_log(const char* msg) {
+		if ((!m_log_buffer.empty()) && (m_log_buffer.back() == 0))
+			m_log_buffer.pop_back();
+		m_log_buffer.insert(m_log_buffer.end(),msg,msg + strlen(msg) + 1);
+	}
+
+	//End of the #version line (defines have to follow it),0 if the source has none
+	static uint32_t version_end(const char* code,const uint32_t len) {
+		const char* end = code + len;
+		for (const char* p = code;(p = (const char*)memchr(p,'#',end - p)) != 0;++p) {
+			if (((end - p) < 8) || (strncmp(p,"#version",8) != 0))
+				continue;
+
+			const char* nl = (const char*)memchr(p,'\n',end - p);
+			return nl ? (uint32_t)(nl + 1 - code) : len;
+		}
+		return 0;
+	}
+
+	/*
+		"#line" directive giving the source line at split (just after the #version line) its own number again.
+		Up to GLSL 1.50 / GLSL ES 1.00 "#line N" numbers the following line N + 1,later versions N.
+	*/
+	static std::string line_directive(const char* code,const uint32_t split) {
+		uint32_t line = 1;
+		for (uint32_t i = 0;i < split;++i)
+			line += code[i] == '\n';
+
+		uint32_t version = 110;		//Without #version
+		const char* p = split ? (const char*)memchr(code,'#',split) : 0;
+		for (;p != 0;p = (const char*)memchr(p + 1,'#',code + split - (p + 1))) {
+			if (((code + split - p) > 8) && (strncmp(p,"#version",8) == 0)) {
+				//Bounded by split,sources need no NUL terminator
+				const char* d = p + 8;
+				while ((d < (code + split)) && ((*d == ' ') || (*d == '\t')))
+					++d;
+				for (version = 0;(d < (code + split)) && (*d >= '0') && (*d <= '9');++d)
+					version = version * 10 + (*d - '0');
+				break;
+			}
+		}
+
+		char tmp[32];
+		sprintf(tmp,"#line %u\n",(version <= 150) ? line - 1 : line);
+		return tmp;
+	}
+
+	void reflect_stage(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines) {
+		if (!m_reflection_cache) {
+			JGLSL_PROFILE_PHASE(JGLSL_PHASE_PARSE);
+			scan_source(m_pending,type,code,len,defines,*m_builtin_types);
+			return;
+		}
+
+		const uint64_t key = stage_hash(type,code,len,defines,jglsl_fnv1a64(0,0));
+		std::map<uint64_t,jglsl_scan_result_t>::iterator it = m_reflection_cache->m_results.find(key);
+		if (it != m_reflection_cache->m_results.end()) {
+			++m_reflection_cache->m_hits;
+		} else {
+			it = m_reflection_cache->m_results.insert(std::make_pair(key,jglsl_scan_result_t())).first;
+			JGLSL_PROFILE_PHASE(JGLSL_PHASE_PARSE);
+			scan_source(it->second,type,code,len,defines,*m_builtin_types);
+		}
+		m_pending.append(it->second);
+	}
+
+	//Defines go after the #version line
+	static GLuint create_shader(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines) {
+		GLuint tmp = glCreateShader(type);
+		if (defines.empty()) {
+			const GLint length = (const GLint)len;
+			glShaderSource(tmp,1,&code,&length);
+		} else {
+			//The #line keeps compile log line numbers pointing at the source
+			const uint32_t split = version_end(code,len);
+			const bool open_line = (split != 0) && (code[split - 1] != '\n');	//#version line without a newline
+			const std::string text = (open_line ? "\n" : "") + defines.text() + line_directive(code,split);
+			const char* strs[3] = { code,text.c_str(),code + split };
+			const GLint lengths[3] = { (GLint)split,(GLint)text.length(),(GLint)(len - split) };
+			glShaderSource(tmp,3,strs,lengths);
+		}
+		glCompileShader(tmp);
+		return tmp;
+	}
+
+	//prepared : reflection from prepare(),0 to scan the source
+	void compile_stage(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines,
+					const jglsl_scan_result_t* prepared = 0) {
+		GLuint tmp = create_shader(type,code,len,defines);
+
+		if (!m_precomputed) {
+			if (prepared)
+				m_pending.append(*prepared);
+			else
+				reflect_stage(type,code,len,defines);
+		}
+		m_shaders.push_back(tmp);
+		m_unchecked_shaders.push_back(tmp);
+	}
+
+	//Shared by load(),load_async() and commit()
+	bool submit_stage(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines,
+					const jglsl_scan_result_t* prepared,const bool async) {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_LOAD);
+		hash_source(type,code,len,defines);
+		if (defer_sources()) {
+			deferred_source_t src;
+			src.type = type;
+			src.code.ptr = 0;
+			src.code.len = 0;
+			src.defines = defines;
+			src.prepared = prepared != 0;
+			m_deferred.push_back(src);
+
+			if (prepared)
+				m_deferred.back().reflection = *prepared;
+			if (m_persistent_sources) {
+				m_deferred.back().code.ptr = code;
+				m_deferred.back().code.len = len;
+			} else {
+				m_deferred.back().owned.assign(code,len);
+			}
+			return true;
+		}
+
+		if (m_hot_reload) {
+			kept_stage_t st;
+			st.type = type;
+			st.code.assign(code,len);
+			st.defines = defines;
+			st.decl_hash = declaration_hash(code,len,defines,*m_builtin_types);
+			m_loaded_stages.push_back(st);
+
+			if (prepared) {
+				m_loaded_stages.back().reflection = *prepared;
+			} else {
+				JGLSL_PROFILE_PHASE(JGLSL_PHASE_PARSE);
+				scan_source(m_loaded_stages.back().reflection,type,code,len,defines,*m_builtin_types);
+			}
+			prepared = &m_loaded_stages.back().reflection;
+		}
+
+		compile_stage(type,code,len,defines,prepared);
+		if (m_hot_reload)
+			m_loaded_stages.back().shader = m_shaders.back();
+		if (async)
+			return true;
+
+		m_unchecked_shaders.pop_back();
+		if (check_shader(m_shaders.back()))
+			return true;
+
+		glDeleteShader(m_shaders.back());
+		m_shaders.pop_back();
+		if (m_hot_reload)
+			m_loaded_stages.pop_back();
+		return false;
+	}
+
+	void drop_stages() {
+		for (uint32_t i = 0,j = m_stages.size();i < j;++i)
+			glDeleteShader(m_stages[i].shader);
+		m_stages.clear();
+		drop_specialized();
+	}
+
+	//Discards a specialized variant still being built
+	void drop_specialized() {
+		if (!m_specialized)
+			return;
+
+		jglsl_program_t* prev = m_prog;
+		m_prog = m_specialized;
+		m_specialized = 0;
+		release_program();
+		m_prog = prev;
+	}
+
+	/*
+		Source with every "uniform type name;" of a specialized uniform replaced by "const type name = value;"
+		(a layout(...) in front of it included).Declarations with several names are left as they are.
+		applied[s] is set for every specs[s] replaced.
+	*/
+	static void specialize_source(const std::string& code,const std::vector<specialization_t>& specs,std::string& out,
+					std::vector<uint8_t>& applied) {
+		std::vector<jglsl_span_t> toks;
+		tokenize(toks,code.c_str(),code.length());
+		out.clear();
+
+		const char* copied = code.c_str();
+		for (uint32_t i = 0,n = toks.size();i < n;++i) {
+			if (toks[i] != "uniform")
+				continue;
+
+			uint32_t t = i + 1;
+			while ((t < n) && is_ignored_qualifier(toks[t]))
+				++t;
+			if (((t + 2) >= n) || (toks[t + 2] != ";"))
+				continue;
+
+			uint32_t s = 0;
+			while ((s < specs.size()) && (toks[t + 1] != specs[s].name.c_str()))
+				++s;
+			if (s == specs.size())
+				continue;
+
+			uint32_t first = i;
+			if ((first > 0) && (toks[first - 1] == ")")) {
+				uint32_t k = first - 1;
+				while ((k > 0) && (toks[k] != "("))
+					--k;
+				if ((k > 0) && (toks[k - 1] == "layout"))
+					first = k - 1;
+			}
+
+			out.append(copied,toks[first].ptr);
+			out += "const ";
+			out.append(toks[t].ptr,toks[t].len);
+			out += ' ';
+			out += specs[s].name;
+			out += " = ";
+			out += specs[s].value;
+			out += ';';
+			applied[s] = 1;
+			copied = toks[t + 2].ptr + 1;
+			i = t + 2;
+		}
+		out.append(copied,code.c_str() + code.length());
+	}
+
+	//Setters on m_prog outside bind() (right after a link) : it is bound meanwhile unless they go through glProgramUniform*
+	GLuint begin_uniform_setup() const {
+		const GLuint prev = jglsl_bind_state().program;
+		if (!(m_dsa || (m_batched && jglsl_gl_caps().program_uniform)))
+			jglsl_use_program(m_prog->id);
+		return prev;
+	}
+
+	void end_uniform_setup(const GLuint prev) const {
+		if (prev != jglsl_unknown_program)
+			jglsl_use_program(prev);
+	}
+
+	//Values held by the shadow copies of from,sent to the uniforms of m_prog with the same names
+	void copy_uniform_values(const jglsl_program_t& from) {
+		const GLuint prev = begin_uniform_setup();
+		for (uint32_t i = 0,j = from.uniforms.slots.size();i < j;++i) {
+			const uniform_slot_t& slot = from.uniforms.slots[i];
+			if ((slot.name == jglsl_invalid_offset) || (slot.value >= from.location_states.size()) || (from.location_states[slot.value] == 0))
+				continue;
+
+			const uniform_state_t& st = from.uniform_states[from.location_states[slot.value] - 1];
+			const char* name = from.uniforms.get_name(slot);
+			const uint32_t* location = m_prog->uniforms.find(name,strlen(name));
+			if ((st.location == slot.value) && (st.bytes != 0) && location)
+				set_uniform(st.kind,*location,st.bytes / kind_size(st.kind),&from.uniform_shadow[st.offset]);
+		}
+		end_uniform_setup(prev);
+	}
+
+	//Swaps the specialized variant in once linked
+	void poll_specialized() {
+		if (jglsl_gl_caps().parallel_compile) {
+			GLint done = GL_FALSE;
+			glGetProgramiv(m_specialized->id,GL_COMPLETION_STATUS_KHR,&done);
+			if (done == GL_FALSE)
+				return;
+		}
+
+		jglsl_program_t* prog = m_specialized;
+		jglsl_program_t* prev = m_prog;
+		m_specialized = 0;
+		m_prog = prog;
+		if (!complete_link()) {
+			release_program();
+			m_prog = prev;
+			refresh_handles();
+			return;
+		}
+
+		copy_uniform_values(*prev);
+		m_prog = prev;
+		release_program();
+		m_prog = prog;
+	}
+
+	void refresh_handles() {
+		for (uint32_t i = 0,j = m_handle_names.size();i < j;++i)
+			m_handle_locations[i] = get_uniform(m_handle_names[i]);
+		refresh_storage_buffers();
+		m_handles_serial = m_prog->serial;
+		m_handles_links = m_prog->links;
+	}
+
+	//A registry program may be linked (or relinked) by another instance sharing it
+	inline void refresh_stale_handles() {
+		if ((m_handles_serial != m_prog->serial) || (m_handles_links != m_prog->links))
+			refresh_handles();
+	}
+
+	void refresh_storage_buffers() {
+		for (uint32_t i = 0,j = m_storage_buffers.size();i < j;++i) {
+			const jglsl_uniform_block_t* b = find_storage_block(m_storage_buffers[i].block);
+			m_storage_buffers[i].binding = (b && (b->index != GL_INVALID_INDEX)) ? b->binding : jglsl_invalid_offset;
+		}
+	}
+
+	//Appends "tag" and the info log of a shader or program,read straight into the log buffer
+	void append_info_log(const char* tag,const GLuint object,const bool program) {
+		GLint len = 0;
+		if (program)
+			glGetProgramiv(object,GL_INFO_LOG_LENGTH,&len);
+		else
+			glGetShaderiv(object,GL_INFO_LOG_LENGTH,&len);
+
+		append_log(tag);
+		m_log_buffer.pop_back();	//NUL goes back after the log
+		const uint32_t at = m_log_buffer.size();
+		if (len > 0) {
+			m_log_buffer.resize(at + len,0);
+			if (program)
+				glGetProgramInfoLog(object,len,NULL,&m_log_buffer[at]);
+			else
+				glGetShaderInfoLog(object,len,NULL,&m_log_buffer[at]);
+			m_log_buffer.erase(std::find(m_log_buffer.begin() + at,m_log_buffer.end(),0),m_log_buffer.end());	//Without the driver's NUL
+		}
+		m_log_buffer.push_back('\n');
+		m_log_buffer.push_back(0);
+	}
+
+	bool check_shader(const GLuint shader) {
+		GLint res;
+		glGetShaderiv(shader,GL_COMPILE_STATUS,&res);
+		if (res != GL_FALSE)
+			return true;
+
+		append_info_log("LD:",shader,false);
+		return false;
+	}
+
+	/*
+		Tables of the reflected names,from explicit layout qualifiers or GL queries (only the former on link errors).
+		Returns false if the program needs more texture/image units than the device has.
+	*/
+	bool resolve_locations(const bool linked) {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_LOCATIONS);
+		const scan_result_t& res = m_prog->reflection;
+		if ((!linked) || res.all_located() || (!add_active_resources(res))) {
+			//Explicit locations are taken as they are,without asking GL
+			for (uint32_t i = 0,j = res.attributes.size();i < j;++i) {
+				if (res.attribute_locations[i] != jglsl_invalid_offset)
+					insert_attribute(res.attributes[i],res.attribute_locations[i],res.attribute_types[i]);
+				else
+					add_attribute(res.attributes[i],res.attribute_types[i]);
+			}
+
+			for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+				if (res.uniform_locations[i] != jglsl_invalid_offset)
+					insert_uniform(res.uniforms[i],res.uniform_locations[i],res.uniform_types[i],
+									(res.uniform_counts[i] == jglsl_invalid_offset) ? 1 : res.uniform_counts[i]);
+				else
+					add_uniform(res.uniforms[i],res.uniform_types[i],res.uniform_counts[i]);
+			}
+		}
+
+		for (uint32_t i = 0,j = m_prog->specialized.size();i < j;++i)
+			m_prog->uniforms.insert(m_prog->specialized[i],0xFFFFFFFFu);	//Setters of it are dropped,not sent to location 0
+
+		finish_vertex_layout();
+		m_prog->blocks.swap(m_prog->reflection.blocks);
+		m_prog->storage_blocks.swap(m_prog->reflection.storage_blocks);
+		for (uint32_t i = 0;i < 3;++i)
+			m_prog->local_size[i] = m_prog->reflection.local_size[i];
+		if (!linked)
+			return true;
+
+		resolve_blocks();
+		resolve_storage_blocks();
+		return resolve_texture_units();
+	}
+
+	static bool is_opaque_type(const std::string& type,bool& image) {
+		image = type.find("image") != std::string::npos;
+		return image || (type.find("sampler") != std::string::npos);
+	}
+
+	/*
+		Gives every reflected sampler (texture units) and image (image units) its unit once per link :
+		layout(binding = N) when declared,otherwise the lowest free units,like storage block bindings.
+		Returns false (log entry,nothing sent) when a unit is past GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS / GL_MAX_IMAGE_UNITS.
+	*/
+	bool resolve_texture_units() {
+		const scan_result_t& res = m_prog->reflection;
+		std::vector<jglsl_texture_unit_t>& units = m_prog->texture_units;
+		std::vector<uint32_t> used[2];	//Units taken in the texture,image space
+
+		for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+			jglsl_texture_unit_t u;
+			const uint32_t* location = m_prog->uniforms.find(res.uniforms[i]);
+			if ((!is_opaque_type(res.uniform_types[i],u.image)) || (!location) || (*location == 0xFFFFFFFFu))
+				continue;
+
+			u.name = res.uniforms[i];
+			u.location = *location;
+			u.count = 1;
+			if ((u.location < m_prog->location_states.size()) && (m_prog->location_states[u.location] != 0))
+				u.count = m_prog->uniform_states[m_prog->location_states[u.location] - 1].count;
+			u.unit = res.uniform_bindings[i];
+
+			if (u.unit != jglsl_invalid_offset) {
+				for (uint32_t k = 0;k < u.count;++k)
+					used[u.image].push_back(u.unit + k);
+			}
+			units.push_back(u);
+		}
+
+		uint32_t next[2] = { 0,0 };
+		for (uint32_t i = 0,j = units.size();i < j;++i) {
+			jglsl_texture_unit_t& u = units[i];
+			if (u.unit != jglsl_invalid_offset)
+				continue;
+
+			//Array elements need consecutive free units
+			std::vector<uint32_t>& taken = used[u.image];
+			for (uint32_t k = 0;k < u.count;) {
+				if (std::find(taken.begin(),taken.end(),next[u.image] + k) == taken.end()) {
+					++k;
+				} else {
+					next[u.image] += k + 1;
+					k = 0;
+				}
+			}
+			u.unit = next[u.image];
+			next[u.image] += u.count;
+		}
+
+		if (units.empty())
+			return true;
+
+		GLint limits[2] = { 0,0 };	//0 : not reported,not checked
+		glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS,&limits[0]);
+		glGetIntegerv(GL_MAX_IMAGE_UNITS,&limits[1]);
+		for (uint32_t i = 0,j = units.size();i < j;++i) {
+			const jglsl_texture_unit_t& u = units[i];
+			if ((limits[u.image] > 0) && ((u.unit + u.count) > (uint32_t)limits[u.image])) {
+				char tmp[256];
+				sprintf(tmp,"LNK:%.128s needs %s units up to %u,the device has %d\n",u.name.c_str(),
+						u.image ? "image" : "texture",u.unit + u.count - 1,limits[u.image]);
+				append_log(tmp);
+				return false;
+			}
+		}
+
+		//Sent through the shadow copies,so u_tex() with the same unit later costs nothing
+		const GLuint prev = begin_uniform_setup();
+		std::vector<GLint> v;
+		for (uint32_t i = 0,j = units.size();i < j;++i) {
+			v.resize(units[i].count);
+			for (uint32_t k = 0;k < units[i].count;++k)
+				v[k] = units[i].unit + k;
+			set_uniform(JGLSL_UK_1I,units[i].location,units[i].count,&v[0]);
+		}
+		end_uniform_setup(prev);
+		return true;
+	}
+
+	//Collects link status/logs and resolves locations,blocks if the driver is still linking
+	bool complete_link() {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_FINALIZE);
+		jglsl_program_t* prog = m_prog;
+		bool ret = true;
+		GLint status;
+
+		for (uint32_t i = 0,j = prog->unchecked_shaders.size();i < j;++i)
+			check_shader(prog->unchecked_shaders[i]);
+		prog->unchecked_shaders.clear();
+
+		glGetProgramiv(m_prog->id, GL_LINK_STATUS, &status);
+		if (status == GL_FALSE) {
+			append_info_log("LNK:",m_prog->id,true);
+			ret = false;
+		}
+
+		if (ret && (!prog->binary_path.empty()))
+			store_binary_cache();
+		prog->binary_path.clear();
+
+		for (uint32_t i = 0,j = prog->shaders.size();i < j;++i)
+			glDeleteShader(prog->shaders[i]);
+		prog->shaders.clear();
+
+		prog->attributes.release();
+		prog->vertex_layout.clear();
+		prog->uniforms.release();
+		prog->texture_units.clear();
+		clear_uniform_states();
+
+		if (ret) 
+			m_log_buffer.clear();
+		if (!resolve_locations(ret))
+			ret = false;
+		if ((!ret) && prog->registry) //Keep sharing it with current users only,the next finalize() recompiles and gets the logs
+			prog->registry->remove(prog);
+		prog->reflection.clear();
+
+		prog->link_pending = false;
+		prog->link_status = ret;
+		++prog->links;
+		refresh_handles();
+		return ret;
+	}
+
+	struct active_resource_t {
+		uint32_t location;
+		GLenum type;
+		uint32_t count;
+		bool reflected;		//Also found by the source scanner
+	};
+	typedef std::map<std::string,active_resource_t> active_resources_t;
+
+#ifdef GL_PROGRAM_INPUT
+	//Every active uniform (outside blocks) or vertex input with a location,arrays under their base name
+	void query_active_resources(const GLenum iface,active_resources_t& out) const {
+		const GLuint id = m_prog->id;
+		const GLenum props[] = { GL_TYPE,GL_ARRAY_SIZE,GL_LOCATION,GL_BLOCK_INDEX };
+		const GLsizei prop_count = (iface == GL_UNIFORM) ? 4 : 3;	//Inputs have no block index
+		GLint n = 0,max_len = 0;
+
+		glGetProgramInterfaceiv(id,iface,GL_ACTIVE_RESOURCES,&n);
+		glGetProgramInterfaceiv(id,iface,GL_MAX_NAME_LENGTH,&max_len);
+		std::vector<GLchar> name(max_len + 1);
+
+		for (GLint i = 0;i < n;++i) {
+			GLint v[4] = { 0,1,-1,-1 };
+			glGetProgramResourceiv(id,iface,i,prop_count,props,4,0,v);
+			if ((v[2] < 0) || (v[3] != -1)) //Built-ins,opaque types without locations,block members (see resolve_blocks())
+				continue;
+
+			GLsizei len = 0;
+			glGetProgramResourceName(id,iface,i,name.size(),&len,&name[0]);
+			if ((len > 3) && (strncmp(&name[len - 3],"[0]",3) == 0))
+				len -= 3;
+
+			active_resource_t r = { (uint32_t)v[2],(GLenum)v[0],(uint32_t)std::max(v[1],1),false };
+			out[std::string(&name[0],len)] = r;
+		}
+	}
+
+	//Names the scanner knows of but GL does not are inactive,they cost no location query
+	static uint32_t take_active(active_resources_t& active,const std::string& name,active_resource_t& r) {
+		active_resources_t::iterator it = active.find(name);
+		if (it == active.end())
+			return 0xFFFFFFFFu;
+
+		it->second.reflected = true;
+		r = it->second;
+		return r.location;
+	}
+#endif
+
+	/*
+		GL 4.3 fast path : locations,types and active array sizes in bulk instead of one query per scanned name.
+		Resources the scanner missed are added with their GL types,debug builds log them along with type mismatches.
+	*/
+	bool add_active_resources(const scan_result_t& res) {
+#ifdef GL_PROGRAM_INPUT
+		if (!jglsl_gl_caps().program_interface)
+			return false;
+
+		active_resources_t inputs,uniforms;
+		query_active_resources(GL_PROGRAM_INPUT,inputs);
+		query_active_resources(GL_UNIFORM,uniforms);
+
+		for (uint32_t i = 0,j = res.attributes.size();i < j;++i) {
+			active_resource_t r;
+			insert_attribute(res.attributes[i],take_active(inputs,res.attributes[i],r),res.attribute_types[i]);
+		}
+
+		for (uint32_t i = 0,j = res.uniforms.size();i < j;++i) {
+			active_resource_t r = { 0,0,1,false };
+			const uint32_t location = take_active(uniforms,res.uniforms[i],r);
+
+#ifndef NDEBUG
+			const char* gl_type = gl_type_name(r.type);
+			if ((location != 0xFFFFFFFFu) && (*gl_type != 0) && (!res.uniform_types[i].empty()) && (res.uniform_types[i] != gl_type))
+				check_log("type mismatch",res.uniforms[i]);
+#endif
+			insert_uniform(res.uniforms[i],location,res.uniform_types[i],r.count);	//Active size,unused trailing elements trimmed
+		}
+
+		for (active_resources_t::const_iterator it = inputs.begin();it != inputs.end();++it) {
+			if (it->second.reflected)
+				continue;
+#ifndef NDEBUG
+			if ((std::find(res.attributes.begin(),res.attributes.end(),it->first) == res.attributes.end()) &&
+				(std::find(res.inputs.begin(),res.inputs.end(),it->first) == res.inputs.end()))
+				check_log("input not found by the scanner",it->first);
+#endif
+			insert_attribute(it->first,it->second.location,gl_type_name(it->second.type));
+		}
+
+		for (active_resources_t::const_iterator it = uniforms.begin();it != uniforms.end();++it) {
+			if (it->second.reflected)
+				continue;
+#ifndef NDEBUG
+			check_log("uniform not found by the scanner",it->first);
+#endif
+			insert_uniform(it->first,it->second.location,gl_type_name(it->second.type),it->second.count);
+		}
+		return true;
+#else
+		(void)res;
+		return false;
+#endif
+	}
+
+#ifndef NDEBUG
+	//Scanner/GL disagreement,kept in the log of a successful link
+	void check_log(const char* what,const std::string& name) {
+		append_log("reflection : ");
+		append_log(what);
+		append_log(" : ");
+		append_log(name.c_str());
+		append_log("\n");
+	}
+#endif
+
+	//Block indices,plus offsets/sizes of shared/packed (or otherwise not computable) layouts straight from GL
+	void resolve_blocks() {
+		const GLuint id = m_prog->id;
+		std::vector<std::string> names;
+		std::vector<const GLchar*> ptrs;
+		std::vector<GLuint> indices,active;
+		std::vector<uint32_t> members;
+		std::vector<GLint> offsets,array_strides,matrix_strides;
+
+		for (uint32_t i = 0,j = m_prog->blocks.size();i < j;++i) {
+			jglsl_uniform_block_t& b = m_prog->blocks[i];
+			b.index = glGetUniformBlockIndex(id,b.name.c_str());
+			if ((b.index == GL_INVALID_INDEX) || (b.size != jglsl_invalid_offset) || b.members.empty())
+				continue;
+
+			GLint size = 0;
+			glGetActiveUniformBlockiv(id,b.index,GL_UNIFORM_BLOCK_DATA_SIZE,&size);
+			b.size = size;
+
+			const uint32_t cnt = b.members.size();
+			names.resize(cnt);
+			ptrs.resize(cnt);
+			for (uint32_t k = 0;k < cnt;++k) {
+				const jglsl_block_member_t& m = b.members[k];
+				names[k] = (b.instance.empty() ? std::string() : b.name + ".") + m.name + ((m.array_count != 1) ? "[0]" : "");
+				ptrs[k] = names[k].c_str();
+			}
+
+			indices.resize(cnt);
+			glGetUniformIndices(id,cnt,&ptrs[0],&indices[0]);
+
+			//Inactive (optimized out) members keep jglsl_invalid_offset
+			active.clear();
+			members.clear();
+			for (uint32_t k = 0;k < cnt;++k) {
+				if (indices[k] != GL_INVALID_INDEX) {
+					active.push_back(indices[k]);
+					members.push_back(k);
+				}
+			}
+			if (active.empty())
+				continue;
+
+			const GLsizei n = active.size();
+			offsets.resize(n);
+			array_strides.resize(n);
+			matrix_strides.resize(n);
+			glGetActiveUniformsiv(id,n,&active[0],GL_UNIFORM_OFFSET,&offsets[0]);
+			glGetActiveUniformsiv(id,n,&active[0],GL_UNIFORM_ARRAY_STRIDE,&array_strides[0]);
+			glGetActiveUniformsiv(id,n,&active[0],GL_UNIFORM_MATRIX_STRIDE,&matrix_strides[0]);
+
+			for (GLsizei k = 0;k < n;++k) {
+				jglsl_block_member_t& m = b.members[members[k]];
+				m.offset = offsets[k];
+				m.array_stride = array_strides[k];
+				m.matrix_stride = matrix_strides[k];
+			}
+		}
+	}
+
+	/*
+		Storage block indices,shared layouts from GL,and a binding for every block the sources leave at
+		the default (all of them would share binding 0 otherwise).
+		The workgroup size of compute programs comes from GL as well,the scanner can miss specialized sizes.
+	*/
+	void resolve_storage_blocks() {
+#ifdef GL_SHADER_STORAGE_BLOCK
+		const GLuint id = m_prog->id;
+		std::vector<uint32_t> used;
+
+		for (uint32_t i = 0,j = m_prog->storage_blocks.size();i < j;++i) {
+			if (m_prog->storage_blocks[i].binding != jglsl_invalid_offset)
+				used.push_back(m_prog->storage_blocks[i].binding);
+		}
+
+		for (uint32_t i = 0,j = m_prog->storage_blocks.size(),next = 0;i < j;++i) {
+			jglsl_uniform_block_t& b = m_prog->storage_blocks[i];
+			b.index = glGetProgramResourceIndex(id,GL_SHADER_STORAGE_BLOCK,b.name.c_str());
+			if (b.index == GL_INVALID_INDEX)
+				continue;
+
+			if (b.binding == jglsl_invalid_offset) {
+				while (std::find(used.begin(),used.end(),next) != used.end())
+					++next;
+				b.binding = next++;
+				glShaderStorageBlockBinding(id,b.index,b.binding);
+			}
+
+			if (b.size != jglsl_invalid_offset)
+				continue;
+
+			const GLenum size_prop = GL_BUFFER_DATA_SIZE;
+			GLint size = 0;
+			glGetProgramResourceiv(id,GL_SHADER_STORAGE_BLOCK,b.index,1,&size_prop,1,0,&size);
+			b.size = size;
+
+			const GLenum props[] = { GL_OFFSET,GL_ARRAY_STRIDE,GL_MATRIX_STRIDE };
+			for (uint32_t k = 0,w = b.members.size();k < w;++k) {
+				jglsl_block_member_t& m = b.members[k];
+				const std::string name = (b.instance.empty() ? std::string() : b.name + ".") + m.name + ((m.array_count != 1) ? "[0]" : "");
+				const GLuint var = glGetProgramResourceIndex(id,GL_BUFFER_VARIABLE,name.c_str());
+				if (var == GL_INVALID_INDEX)
+					continue;
+
+				GLint v[3] = { 0,0,0 };
+				glGetProgramResourceiv(id,GL_BUFFER_VARIABLE,var,3,props,3,0,v);
+				m.offset = v[0];
+				m.array_stride = v[1];
+				m.matrix_stride = v[2];
+			}
+		}
+
+		if (m_prog->stage_bits & GL_COMPUTE_SHADER_BIT) {
+			GLint size[3] = { 0,0,0 };
+			glGetProgramiv(id,GL_COMPUTE_WORK_GROUP_SIZE,size);
+			if (size[0] > 0) {
+				for (uint32_t i = 0;i < 3;++i)
+					m_prog->local_size[i] = size[i];
+			}
+		}
+#endif
+	}
+
+	//Drops this instance's reference,the last one deletes the program
+	void release_program() {
+		jglsl_program_t* prog = m_prog;
+		m_prog = jglsl_program_t::null_program();
+		if ((prog == m_prog) || (--prog->refs != 0))
+			return;
+
+		if (prog->registry)
+			prog->registry->remove(prog);
+
+		if (prog->id != 0) {
+			jglsl_bind_state_t& state = jglsl_bind_state();
+			if ((state.program == prog->id) || (state.program == jglsl_unknown_program)) {
+				unbind();
+				if (state.keep_bound) //Still in use by GL,but the id may be handed out again
+					state.program = jglsl_unknown_program;
+			}
+			glDeleteProgram(prog->id);
+		}
+
+		for (uint32_t i = 0,j = prog->shaders.size();i < j;++i)
+			glDeleteShader(prog->shaders[i]);
+		delete prog;
+	}
+
+	//Discards everything load() gathered since the last finalize()
+	void drop_sources() {
+		for (uint32_t i = 0,j = m_shaders.size();i < j;++i)
+			glDeleteShader(m_shaders[i]);
+
+		m_shaders.clear();
+		m_unchecked_shaders.clear();
+		m_deferred.clear();
+		m_loaded_stages.clear();
+		m_pending.clear();
+		m_precomputed = false;
+		m_source_hash = jglsl_fnv1a64(0,0);
+		m_stage_bits = 0;
+	}
+
+	//Built once,shared by every instance that did not register types of its own
+	static const jglsl_builtin_types_t& std_builtin_types() {
+		struct std_types_t : jglsl_builtin_types_t {
+			std_types_t() {
+				add("int",false);
+				add("uint",false);
+				add("bool",false);
+				add("float",false);
+				add("double",false);
+				add("atomic_uint",false);
+				add("vec",true);
+				add("mat",true);
+				add("image",true);
+				add("sampler",true);
+			}
+		};
+		static const std_types_t types;
+		return types;
+	}
+
+	//Declaration scanner : one tokenizer pass per load(),tokens are spans into the caller's buffer
+	struct scan_struct_t;
+
+	struct scan_member_t {
+		jglsl_span_t name;
+		jglsl_span_t type;
+		const scan_struct_t* st;	//Struct typed member
+		uint32_t count;				//Array elements (1 : not an array,0 : runtime sized,jglsl_invalid_offset : not a literal)
+		bool row_major;
+	};
+
+	//Flattened field ("f.a2","arr[1].a2"),the name is interned into scan_ctx_t::names
+	struct scan_field_t {
+		uint32_t name;			//Offset into scan_ctx_t::names
+		uint32_t name_len;
+		jglsl_span_t type;		//Builtin type
+		uint32_t count;			//Array size
+	};
+
+	struct scan_struct_t {
+		jglsl_span_t name;
+		uint32_t first_field;				//Flattened fields : scan_ctx_t::fields[first_field,first_field + field_count)
+		uint32_t field_count;
+		uint32_t first_member;				//Direct fields,for block layouts : scan_ctx_t::members[first_member,first_member + member_count)
+		uint32_t member_count;
+		uint32_t align[2];					//std140,std430 (0 : can not be laid out)
+		uint32_t size[2];
+	};
+
+	struct scan_const_t {
+		jglsl_span_t name;
+		uint32_t value;
+	};
+
+	/*
+		Per source scanner state.One per thread (see acquire()),its storage is reused by the following scans
+		instead of being allocated again for every source.
+	*/
+	struct scan_ctx_t {
+		const jglsl_builtin_types_t* types;
+		std::vector<jglsl_span_t> toks;
+		std::vector<scan_struct_t> structs;
+		std::vector<scan_field_t> fields;	//Flattened fields of every struct,then scratch space of the current declaration
+		std::vector<scan_member_t> members;	//Direct fields of every struct,then those of the current interface block
+		std::vector<char> names;			//Field names,not NUL terminated
+		std::vector<scan_const_t> consts;	//Global integral constants and integral #defines,usable in array sizes
+		std::vector<jglsl_span_t> macros;	//Every #define in effect (for defined())
+		std::vector<jglsl_span_t> directive_toks;	//scan_directive()
+		std::vector<jglsl_span_t> value_toks;		//define_macro()
+		std::vector<uint8_t> pp_stack;		//Open conditionals
+		std::string filtered;				//Output of preprocess() when it disabled lines
+
+		scan_ctx_t() : types(0) {}
+
+		//Emptied context of the calling thread,scans must not nest
+		static scan_ctx_t& acquire(const jglsl_builtin_types_t& builtin) {
+			static thread_local scan_ctx_t ctx;
+			ctx.types = &builtin;
+			ctx.toks.clear();
+			ctx.structs.clear();
+			ctx.fields.clear();
+			ctx.members.clear();
+			ctx.names.clear();
+			ctx.consts.clear();
+			ctx.macros.clear();
+			ctx.pp_stack.clear();
+			ctx.filtered.clear();
+			return ctx;
+		}
+
+		inline bool is_builtin(const jglsl_span_t& s) const {
+			return types->match(s);
+		}
+
+		inline const scan_struct_t* find(const jglsl_span_t& s) const {
+			return find_struct(s,structs);
+		}
+	};
+
+	//Qualifiers found in layout(...)
+	struct scan_layout_t {
+		int32_t packing;	//JGLSL_LAYOUT_*,-1 : not given
+		int32_t row_major;	//-1 : not given
+		int32_t location;	//-1 : not given
+		int32_t binding;	//-1 : not given
+		int32_t local_size[3];	//-1 : not given
+	};
+
+	static inline bool is_ident_char(const char c) {
+		return ((uint32_t)((c | 0x20) - 'a') < 26) || ((uint32_t)(c - '0') < 10) || (c == '_');
+	}
+
+	static inline bool is_blank(const char c) {
+		return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\f') || (c == '\v');
+	}
+
+	//Skips a comment or directive starting at p (if any),returns p otherwise
+	static inline const char* skip_comment(const char* p,const char* end,const bool line_start) {
+		if ((*p == '/') && ((p + 1) < end)) {
+			if (p[1] == '/') {
+				while ((p < end) && (*p != '\n'))
+					++p;
+			} else if (p[1] == '*') {
+				p += 2;
+				while (((p + 1) < end) && ((p[0] != '*') || (p[1] != '/')))
+					++p;
+				p = ((p + 1) < end) ? p + 2 : end;
+			}
+		} else if ((*p == '#') && line_start) { //Directive,up to the first newline not escaped by '\'
+			while ((p < end) && (*p != '\n')) {
+				if (*p == '\\') {
+					++p;
+					if ((p < end) && (*p == '\r'))
+						++p;
+				}
+				if (p < end)
+					++p;
+			}
+		}
+		return p;
+	}
+
+	/*
+		Splits the source into identifier/number and single character punctuation spans.
+		Function bodies ('{' right after ')') carry no declarations,they are skipped at character level
+		and only their braces are emitted.
+	*/
+	static void tokenize(std::vector<jglsl_span_t>& toks,const char* code,const uint32_t len) {
+		const char* p = code;
+		const char* end = code + len;
+		bool line_start = true;
+
+		while (p < end) {
+			const char c = *p;
+
+			if (c == '\n') {
+				line_start = true;
+				++p;
+				continue;
+			} else if (is_blank(c)) {
+				++p;
+				continue;
+			}
+
+			const char* q = skip_comment(p,end,line_start);
+			if (q != p) {
+				p = q;
+				continue;
+			}
+
+			jglsl_span_t tok;
+			tok.ptr = p;
+			if (is_ident_char(c)) {
+				while ((p < end) && is_ident_char(*p))
+					++p;
+			} else if ((c == '{') && (!toks.empty()) && (toks.back() == ")")) {
+				uint32_t depth = 1;
+				toks.push_back(tok);
+				toks.back().len = 1;
+
+				for (++p;(p < end) && (depth > 0);) {
+					const char* close = (const char*)memchr(p,'}',end - p);
+					if (!close) {
+						p = end;
+						break;
+					}
+
+					const char* first = close;
+					const char* open = (const char*)memchr(p,'{',first - p);
+					first = open ? open : first;
+					const char* slash = (const char*)memchr(p,'/',first - p);
+					first = slash ? slash : first;
+					const char* hash = (const char*)memchr(p,'#',first - p);
+					first = hash ? hash : first;
+
+					if (first == close) {
+						--depth;
+						p = close + 1;
+					} else if (first == open) {
+						++depth;
+						p = open + 1;
+					} else {
+						const char* bol = first;
+						while ((bol > code) && is_blank(bol[-1]))
+							--bol;
+						q = skip_comment(first,end,(bol == code) || (bol[-1] == '\n'));
+						p = (q != first) ? q : first + 1;
+					}
+				}
+
+				tok.ptr = p - 1;
+				if (depth > 0) //Unterminated body
+					break;
+			} else {
+				++p;
+			}
+
+			tok.len = (uint32_t)(p - tok.ptr);
+			toks.push_back(tok);
+			line_start = false;
+		}
+	}
+
+	//Keywords of declarations,see scan_keyword()
+	static const uint8_t kw_none = 0;
+	static const uint8_t kw_ignored = 1;	//Qualifier that carries no information for us
+	static const uint8_t kw_const = 2;
+	static const uint8_t kw_layout = 3;
+	static const uint8_t kw_uniform = 4;
+	static const uint8_t kw_attribute = 5;
+	static const uint8_t kw_in = 6;
+	static const uint8_t kw_out = 7;
+	static const uint8_t kw_buffer = 8;
+
+	//One switch on the first character instead of a compare against every keyword
+	static uint8_t scan_keyword(const jglsl_span_t& t) {
+		if (t.len < 2)
+			return kw_none;
+
+		switch (t.ptr[0]) {
+			case 'a': return (t == "attribute") ? kw_attribute : kw_none;
+			case 'b': return (t == "buffer") ? kw_buffer : kw_none;
+			case 'c': return (t == "const") ? kw_const : ((t == "centroid") || (t == "coherent")) ? kw_ignored : kw_none;
+			case 'f': return (t == "flat") ? kw_ignored : kw_none;
+			case 'h': return (t == "highp") ? kw_ignored : kw_none;
+			case 'i': return (t == "in") ? kw_in : ((t == "inout") || (t == "invariant")) ? kw_ignored : kw_none;
+			case 'l': return (t == "layout") ? kw_layout : (t == "lowp") ? kw_ignored : kw_none;
+			case 'm': return (t == "mediump") ? kw_ignored : kw_none;
+			case 'n': return (t == "noperspective") ? kw_ignored : kw_none;
+			case 'o': return (t == "out") ? kw_out : kw_none;
+			case 'p': return ((t == "patch") || (t == "precise")) ? kw_ignored : kw_none;
+			case 'r': return ((t == "readonly") || (t == "restrict")) ? kw_ignored : kw_none;
+			case 's': return ((t == "sample") || (t == "smooth")) ? kw_ignored : kw_none;
+			case 'u': return (t == "uniform") ? kw_uniform : kw_none;
+			case 'v': return ((t == "volatile") || (t == "varying")) ? kw_ignored : kw_none;
+			case 'w': return (t == "writeonly") ? kw_ignored : kw_none;
+		}
+		return kw_none;
+	}
+
+	//Qualifiers that may precede the type and carry no information for us
+	static inline bool is_ignored_qualifier(const jglsl_span_t& t) {
+		const uint8_t kw = scan_keyword(t);
+		return (kw == kw_ignored) || (kw == kw_const);
+	}
+
+	static const scan_struct_t* find_struct(const jglsl_span_t& name,const std::vector<scan_struct_t>& structs) {
+		for (uint32_t i = 0,j = structs.size();i < j;++i) {
+			if (structs[i].name == name)
+				return &structs[i];
+		}
+		return 0;
+	}
+
+	//Decimal/hex/octal literal with an optional u suffix
+	static bool parse_uint(const jglsl_span_t& t,uint32_t& v) {
+		uint32_t i = 0,base = 10,len = t.len;
+		v = 0;
+
+		if ((len > 0) && ((t.ptr[len - 1] == 'u') || (t.ptr[len - 1] == 'U')))
+			--len;
+		if ((len > 2) && (t.ptr[0] == '0') && ((t.ptr[1] == 'x') || (t.ptr[1] == 'X'))) {
+			base = 16;
+			i = 2;
+		} else if ((len > 1) && (t.ptr[0] == '0')) {
+			base = 8;
+			i = 1;
+		}
+
+		if (i >= len)
+			return false;
+
+		for (;i < len;++i) {
+			const char c = t.ptr[i];
+			uint32_t d;
+			if ((c >= '0') && (c <= '9'))
+				d = c - '0';
+			else if ((c >= 'a') && (c <= 'f'))
+				d = c - 'a' + 10;
+			else if ((c >= 'A') && (c <= 'F'))
+				d = c - 'A' + 10;
+			else
+				return false;
+
+			if (d >= base)
+				return false;
+			v = v * base + d;
+		}
+		return true;
+	}
+
+	//toks[i] is the opening token,returns the index past its matching closing token
+	static uint32_t skip_group(const std::vector<jglsl_span_t>& toks,uint32_t i,const char open,const char close) {
+		uint32_t depth = 0;
+		for (const uint32_t n = toks.size();i < n;++i) {
+			if (toks[i].len != 1)
+				continue;
+			if (toks[i].ptr[0] == open) {
+				++depth;
+			} else if ((toks[i].ptr[0] == close) && (--depth == 0)) {
+				return i + 1;
+			}
+		}
+		return i;
+	}
+
+	static const scan_const_t* find_const(const jglsl_span_t& name,const std::vector<scan_const_t>& consts) {
+		for (uint32_t i = 0,j = consts.size();i < j;++i) {
+			if (consts[i].name == name)
+				return &consts[i];
+		}
+		return 0;
+	}
+
+	static bool find_macro(const jglsl_span_t& name,const std::vector<jglsl_span_t>& macros) {
+		return std::find(macros.begin(),macros.end(),name) != macros.end();
+	}
+
+	//pp : #if expression (defined(),unknown identifiers are 0)
+	static bool eval_primary(const scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t& i,const uint32_t end,
+					uint32_t& v,const bool pp) {
+		if (i >= end)
+			return false;
+
+		const jglsl_span_t& t = toks[i++];
+		if (t == "(") {
+			if ((!eval_const_expr(ctx,toks,i,end,v,1,pp)) || (i >= end) || (toks[i] != ")"))
+				return false;
+			++i;
+			return true;
+		} else if ((t == "-") || (t == "~") || (t == "!")) {
+			if (!eval_primary(ctx,toks,i,end,v,pp))
+				return false;
+			v = (t == "-") ? (uint32_t)(-(int32_t)v) : (t == "~") ? ~v : (uint32_t)(v == 0);
+			return true;
+		} else if ((t == "+") || (t == "int") || (t == "uint")) { //Constructors are plain parentheses here
+			return eval_primary(ctx,toks,i,end,v,pp);
+		} else if (pp && (t == "defined")) {
+			const bool paren = (i < end) && (toks[i] == "(");
+			i += paren;
+			if (i >= end)
+				return false;
+
+			v = find_macro(toks[i++],ctx.macros);
+			if (paren) {
+				if ((i >= end) || (toks[i] != ")"))
+					return false;
+				++i;
+			}
+			return true;
+		}
+
+		if (parse_uint(t,v))
+			return true;
+
+		const scan_const_t* c = find_const(t,ctx.consts);
+		v = c ? c->value : 0;
+		return (c != 0) || (pp && is_ident_char(*t.ptr));
+	}
+
+	//Binary operator at toks[i] (0 if none),two character operators are adjacent tokens
+	static uint32_t binary_precedence(const std::vector<jglsl_span_t>& toks,const uint32_t i,const uint32_t end,uint32_t& op_len) {
+		if (toks[i].len != 1)
+			return 0;
+
+		const char c = toks[i].ptr[0];
+		const char next = (((i + 1) < end) && (toks[i + 1].len == 1) && (toks[i + 1].ptr == (toks[i].ptr + 1))) ? toks[i + 1].ptr[0] : 0;
+		op_len = 1;
+		switch (c) {
+			case '|':
+				op_len += next == '|';
+				return (op_len == 2) ? 1 : 3;
+			case '&':
+				op_len += next == '&';
+				return (op_len == 2) ? 2 : 5;
+			case '^': return 4;
+			case '=':
+			case '!':
+				op_len = 2;
+				return (next == '=') ? 6 : 0;
+			case '<':
+			case '>':
+				op_len += (next == c) || (next == '=');
+				return (next == c) ? 8 : 7;
+			case '+':
+			case '-': return 9;
+			case '*':
+			case '/':
+			case '%': return 10;
+		}
+		return 0;
+	}
+
+	//Integral constant expression in toks[i,end) : literals,global constants,C operators
+	static bool eval_const_expr(const scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t& i,const uint32_t end,
+					uint32_t& v,const uint32_t min_precedence = 1,const bool pp = false) {
+		if (!eval_primary(ctx,toks,i,end,v,pp))
+			return false;
+
+		while (i < end) {
+			uint32_t op_len,rhs;
+			const uint32_t prec = binary_precedence(toks,i,end,op_len);
+			if ((prec == 0) || (prec < min_precedence))
+				return true;
+
+			const char op = toks[i].ptr[0];
+			const char op2 = (op_len == 2) ? toks[i + 1].ptr[0] : 0;
+			i += op_len;
+			if (!eval_const_expr(ctx,toks,i,end,rhs,prec + 1,pp))
+				return false;
+
+			const int32_t a = (int32_t)v,b = (int32_t)rhs;
+			switch (op) {
+				case '|': v = (op2 == '|') ? ((v != 0) || (rhs != 0)) : (v | rhs); break;
+				case '&': v = (op2 == '&') ? ((v != 0) && (rhs != 0)) : (v & rhs); break;
+				case '^': v ^= rhs; break;
+				case '=': v = v == rhs; break;
+				case '!': v = v != rhs; break;
+				case '<': v = (op2 == '<') ? ((rhs < 32) ? v << rhs : 0) : (op2 == '=') ? (a <= b) : (a < b); break;
+				case '>': v = (op2 == '>') ? ((rhs < 32) ? v >> rhs : 0) : (op2 == '=') ? (a >= b) : (a > b); break;
+				case '+': v += rhs; break;
+				case '-': v -= rhs; break;
+				case '*': v *= rhs; break;
+				case '/': if (rhs == 0) return false; v = (uint32_t)(a / b); break;
+				case '%': if (rhs == 0) return false; v = (uint32_t)(a % b); break;
+			}
+		}
+		return true;
+	}
+
+	//Tokens of directive text,backslash-newline continuations join the lines
+	static void tokenize_directive(std::vector<jglsl_span_t>& toks,const char* p,const uint32_t len) {
+		toks.clear();
+		tokenize(toks,p,len);
+		for (uint32_t i = 0;i < toks.size();++i) {
+			if (toks[i] == "\\")
+				toks.erase(toks.begin() + i--);
+		}
+	}
+
+	static void define_macro(scan_ctx_t& ctx,const jglsl_span_t& name,const jglsl_span_t& value) {
+		std::vector<jglsl_span_t>& toks = ctx.value_toks;
+		uint32_t i = 0;
+		scan_const_t c;
+
+		undefine_macro(ctx,name);
+		ctx.macros.push_back(name);
+
+		tokenize_directive(toks,value.ptr,value.len);
+		c.name = name;
+		if ((!toks.empty()) && eval_const_expr(ctx,toks,i,toks.size(),c.value) && (i == toks.size()))
+			ctx.consts.push_back(c);
+	}
+
+	static void undefine_macro(scan_ctx_t& ctx,const jglsl_span_t& name) {
+		for (uint32_t i = 0;i < ctx.macros.size();++i) {
+			if (ctx.macros[i] == name)
+				ctx.macros.erase(ctx.macros.begin() + i--);
+		}
+		for (uint32_t i = 0;i < ctx.consts.size();++i) {
+			if (ctx.consts[i].name == name)
+				ctx.consts.erase(ctx.consts.begin() + i--);
+		}
+	}
+
+	//Per open conditional
+	static const uint8_t pp_active = 1;		//Current branch is compiled
+	static const uint8_t pp_taken = 2;		//A branch was already taken
+	static const uint8_t pp_parent = 4;		//Enclosing code is compiled
+
+	//Directive in [p,end) (past the '#'),returns whether the following lines are compiled
+	static bool scan_directive(scan_ctx_t& ctx,const char* p,const char* end) {
+		std::vector<jglsl_span_t>& toks = ctx.directive_toks;
+		std::vector<uint8_t>& stack = ctx.pp_stack;
+		const bool active = stack.empty() || (stack.back() & pp_active);
+
+		tokenize_directive(toks,p,(uint32_t)(end - p));
+		if (toks.empty())
+			return active;
+
+		const jglsl_span_t& d = toks[0];
+		const uint32_t n = toks.size();
+		if ((d == "if") || (d == "ifdef") || (d == "ifndef")) {
+			bool taken = false;
+			if (active && (d == "if")) {
+				uint32_t i = 1,v;
+				taken = eval_const_expr(ctx,toks,i,n,v,1,true) && (v != 0);
+			} else if (active && (n > 1)) {
+				taken = find_macro(toks[1],ctx.macros) == (d == "ifdef");
+			}
+			stack.push_back((active ? pp_parent : 0) | (taken ? (pp_active | pp_taken) : 0));
+		} else if (((d == "elif") || (d == "else")) && (!stack.empty())) {
+			uint8_t& st = stack.back();
+			bool taken = (st & pp_parent) && (!(st & pp_taken));
+			if (taken && (d == "elif")) {
+				uint32_t i = 1,v;
+				taken = eval_const_expr(ctx,toks,i,n,v,1,true) && (v != 0);
+			}
+			st = (st & (pp_parent | pp_taken)) | (taken ? (pp_active | pp_taken) : 0);
+		} else if ((d == "endif") && (!stack.empty())) {
+			stack.pop_back();
+		} else if (active && (d == "define") && (n > 1)) {
+			const char* value = toks[1].ptr + toks[1].len;
+			if ((value < end) && (*value == '(')) //Function-like,only its name matters
+				value = end;
+
+			jglsl_span_t v = { value,(uint32_t)(end - value) };
+			define_macro(ctx,toks[1],v);
+		} else if (active && (d == "undef") && (n > 1)) {
+			undefine_macro(ctx,toks[1]);
+		}
+
+		return stack.empty() || (stack.back() & pp_active);
+	}
+
+	/*
+		Evaluates conditionals and collects #defines ahead of tokenizing.
+		Returns the source itself when no line was disabled,otherwise the compiled lines copied into ctx.filtered.
+	*/
+	static jglsl_span_t preprocess(scan_ctx_t& ctx,const char* code,const uint32_t len) {
+		const char* p = code;
+		const char* end = code + len;
+		const char* run = code;		//Start of the compiled lines not copied yet
+		std::string& filtered = ctx.filtered;
+		bool active = true,disabled = false;
+
+		while (p < end) { //p is at a line start
+			const char* q = p;
+			while ((q < end) && is_blank(*q))
+				++q;
+
+			if ((q < end) && (*q == '#')) {
+				const char* e = skip_comment(q,end,true);
+				const bool was_active = active;
+				active = scan_directive(ctx,q + 1,e);
+				p = (e < end) ? e + 1 : end;
+
+				if (was_active && (!active)) {
+					filtered.append(run,p - run);
+					disabled = true;
+				} else if (active && (!was_active)) {
+					run = p;
+				}
+				continue;
+			}
+
+			//Rest of the line,a block comment may carry it over to later lines
+			for (;;) {
+				const char* nl = (const char*)memchr(q,'\n',end - q);
+				nl = nl ? nl : end;
+				const char* slash = (const char*)memchr(q,'/',nl - q);
+				if (!slash) {
+					q = nl;
+					break;
+				}
+
+				const char* c = skip_comment(slash,end,false);
+				q = (c != slash) ? c : slash + 1;
+			}
+			p = (q < end) ? q + 1 : end;
+		}
+
+		jglsl_span_t ret = { code,len };
+		if (!disabled)
+			return ret;
+
+		if (active)
+			filtered.append(run,end - run);
+		ret.ptr = filtered.c_str();
+		ret.len = filtered.length();
+		return ret;
+	}
+
+	//Cheap test for directives the scanner has to evaluate (#version/#extension/#pragma lines alone need no pass)
+	static bool needs_preprocess(const char* code,const uint32_t len) {
+		for (const char* p = code,*end = code + len;(p = (const char*)memchr(p,'#',end - p)) != 0;++p) {
+			const char* d = p + 1;
+			while ((d < end) && is_blank(*d))
+				++d;
+			if (((end - d) >= 2) && ((strncmp(d,"if",2) == 0) || (strncmp(d,"de",2) == 0) || (strncmp(d,"un",2) == 0)))
+				return true;
+		}
+		return false;
+	}
+
+	//toks[i] is the type of "const int N = 4,M = N * 2;",returns the index of the terminating ';'
+	static uint32_t scan_constants(scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t i) {
+		const uint32_t n = toks.size();
+
+		for (++i;(i < n) && (toks[i] != ";");) {
+			scan_const_t c;
+			c.name = toks[i++];
+
+			uint32_t end = i;
+			while ((end < n) && (toks[end] != ",") && (toks[end] != ";"))
+				end += (toks[end] == "(") ? skip_group(toks,end,'(',')') - end : 1;
+
+			if ((i < end) && (toks[i] == "=")) {
+				++i;
+				if (eval_const_expr(ctx,toks,i,end,c.value) && (i == end))
+					ctx.consts.push_back(c);
+			}
+
+			i = end + ((end < n) && (toks[end] == ","));
+		}
+		return i;
+	}
+
+	//Appends len bytes to the name table,returns their offset
+	static uint32_t intern_name(scan_ctx_t& ctx,const char* s,const uint32_t len) {
+		const uint32_t offs = ctx.names.size();
+		for (uint32_t k = 0;k < len;++k)	//Names are short,cheaper than the range insert
+			ctx.names.push_back(s[k]);
+		return offs;
+	}
+
+	//Copy of a name already in the table (the source may move while the table grows)
+	static uint32_t intern_name(scan_ctx_t& ctx,const uint32_t src,const uint32_t len) {
+		const uint32_t offs = ctx.names.size();
+		for (uint32_t k = 0;k < len;++k) {
+			const char c = ctx.names[src + k];
+			ctx.names.push_back(c);
+		}
+		return offs;
+	}
+
+	//"name." or "name[e].",returns its length
+	static uint32_t intern_element_prefix(scan_ctx_t& ctx,const jglsl_span_t& name,const uint32_t count,const uint32_t e) {
+		char idx[16];
+		const uint32_t len = (count == 1) ? (uint32_t)sprintf(idx,".") : (uint32_t)sprintf(idx,"[%u].",e);
+		intern_name(ctx,name.ptr,name.len);
+		intern_name(ctx,idx,len);
+		return name.len + len;
+	}
+
+	/*
+		Reads "name[N],name2;" for the given type.Struct typed declarators are flattened through the struct table,
+		struct arrays element by element ("name[2].field"),onto ctx.fields when flatten is set.
+		Stops on the terminating ';' (or '}' when used for struct bodies).
+	*/
+	static uint32_t scan_declarators(scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t i,const jglsl_span_t& type,
+					const scan_struct_t* st,const bool flatten,std::vector<scan_member_t>* members = 0,const bool row_major = false) {
+		const uint32_t n = toks.size();
+
+		while ((i < n) && (toks[i] != ";") && (toks[i] != "}")) {
+			const jglsl_span_t& name = toks[i++];
+			uint32_t count = 1;
+
+			while ((i < n) && (toks[i] == "[")) {
+				const uint32_t end = skip_group(toks,i,'[',']');
+				uint32_t dim,k = i + 1;
+
+				if (end == (i + 2))
+					count = (count == jglsl_invalid_offset) ? count : 0;
+				else if (eval_const_expr(ctx,toks,k,end - 1,dim) && (k == (end - 1)) && (count != jglsl_invalid_offset))
+					count *= dim;
+				else
+					count = jglsl_invalid_offset;
+				i = end;
+			}
+
+			if (members) {
+				scan_member_t m = { name,type,st,count,row_major };
+				members->push_back(m);
+			}
+
+			if (flatten) {
+				if (st) {
+					//Sizes that could not be evaluated only expose the first element
+					const uint32_t elems = ((count == 0) || (count == jglsl_invalid_offset)) ? 1 : count;
+					for (uint32_t e = 0;e < elems;++e) {
+						const uint32_t prefix = ctx.names.size();
+						const uint32_t prefix_len = intern_element_prefix(ctx,name,count,e);
+						for (uint32_t f = st->first_field,w = st->first_field + st->field_count;f < w;++f) {
+							scan_field_t field = ctx.fields[f];
+							const uint32_t offs = intern_name(ctx,prefix,prefix_len);
+							intern_name(ctx,field.name,field.name_len);
+							field.name = offs;
+							field.name_len += prefix_len;
+							ctx.fields.push_back(field);
+						}
+					}
+				} else {
+					const scan_field_t field = { intern_name(ctx,name.ptr,name.len),name.len,type,count };
+					ctx.fields.push_back(field);
+				}
+			}
+
+			//Initializers (const arrays etc) are skipped as a whole
+			while ((i < n) && (toks[i] != ",") && (toks[i] != ";") && (toks[i] != "}")) {
+				if (toks[i] == "(")
+					i = skip_group(toks,i,'(',')');
+				else if (toks[i] == "{")
+					i = skip_group(toks,i,'{','}');
+				else
+					++i;
+			}
+
+			if ((i < n) && (toks[i] == ","))
+				++i;
+		}
+
+		return i;
+	}
+
+	//toks[i] == "struct".Fills up structure list and also handles structure->structure access.
+	static uint32_t scan_struct(scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t i,const scan_struct_t** res) {
+		const uint32_t n = toks.size();
+		scan_struct_t def;
+
+		*res = 0;
+		def.name.ptr = "";
+		def.name.len = 0;
+		def.first_field = ctx.fields.size();
+		def.field_count = 0;
+		def.first_member = ctx.members.size();
+		def.member_count = 0;
+
+		if ((++i < n) && (toks[i] != "{"))
+			def.name = toks[i++];
+
+		if ((i >= n) || (toks[i] != "{")) {
+			*res = ctx.find(def.name);
+			return i;
+		}
+
+		++i;
+		while ((i < n) && (toks[i] != "}")) {
+			while ((i < n) && is_ignored_qualifier(toks[i]))
+				++i;
+			if (i >= n)
+				break;
+
+			const jglsl_span_t& type = toks[i++];
+			const scan_struct_t* nested = 0;
+			const bool builtin = ctx.is_builtin(type);
+			if (!builtin)
+				nested = ctx.find(type);
+
+			i = scan_declarators(ctx,toks,i,type,nested,builtin || nested,&ctx.members);
+
+			if ((i < n) && (toks[i] == ";"))
+				++i;
+		}
+
+		if (i >= n) {
+			ctx.fields.resize(def.first_field);
+			ctx.members.resize(def.first_member);
+			return n;
+		}
+
+		def.field_count = ctx.fields.size() - def.first_field;
+		def.member_count = ctx.members.size() - def.first_member;
+		struct_layout(ctx,def,false);
+		struct_layout(ctx,def,true);
+		ctx.structs.push_back(def);
+		*res = &ctx.structs.back();
+		return i + 1;
+	}
+
+	static inline uint32_t align_up(const uint32_t v,const uint32_t a) {
+		return (v + a - 1) & ~(a - 1);
+	}
+
+	//Base alignment/size of a builtin non opaque type as laid out in a std140/std430 block
+	static bool basic_layout(const jglsl_span_t& type,const bool row_major,const bool std430,
+					uint32_t& align,uint32_t& size,uint32_t& matrix_stride) {
+		const char* p = type.ptr;
+		const char* end = type.ptr + type.len;
+		uint32_t scalar = 4;
+
+		matrix_stride = 0;
+		if ((type == "float") || (type == "int") || (type == "uint") || (type == "bool")) {
+			align = size = 4;
+			return true;
+		} else if (type == "double") {
+			align = size = 8;
+			return true;
+		}
+
+		if (*p == 'd') {
+			scalar = 8;
+			++p;
+		} else if ((*p == 'i') || (*p == 'u') || (*p == 'b')) {
+			++p;
+		}
+
+		if (((end - p) == 4) && (memcmp(p,"vec",3) == 0) && (p[3] >= '2') && (p[3] <= '4')) {
+			const uint32_t c = p[3] - '0';
+			align = scalar * ((c == 2) ? 2 : 4);
+			size = scalar * c;
+			return true;
+		}
+
+		if ((scalar == 4) && (p != type.ptr))	//No integer/bool matrices
+			return false;
+		if (((end - p) < 4) || (memcmp(p,"mat",3) != 0) || (p[3] < '2') || (p[3] > '4'))
+			return false;
+
+		const uint32_t cols = p[3] - '0';
+		uint32_t rows = cols;
+		if ((end - p) == 6) {
+			if ((p[4] != 'x') || (p[5] < '2') || (p[5] > '4'))
+				return false;
+			rows = p[5] - '0';
+		} else if ((end - p) != 4) {
+			return false;
+		}
+
+		//An array of column (row if row_major) vectors
+		const uint32_t vec = row_major ? cols : rows;
+		const uint32_t cnt = row_major ? rows : cols;
+		align = scalar * ((vec == 2) ? 2 : 4);
+		if (!std430)
+			align = align_up(align,16);
+		matrix_stride = align;
+		size = cnt * matrix_stride;
+		return true;
+	}
+
+	static bool member_layout(const scan_member_t& m,const bool std430,
+					uint32_t& align,uint32_t& size,uint32_t& stride,uint32_t& matrix_stride) {
+		if (m.count == jglsl_invalid_offset)
+			return false;
+
+		if (m.st) {
+			align = m.st->align[std430];
+			size = m.st->size[std430];
+			matrix_stride = 0;
+			if (align == 0)
+				return false;
+		} else if (!basic_layout(m.type,m.row_major,std430,align,size,matrix_stride)) {
+			return false;
+		}
+
+		stride = 0;
+		if (m.count != 1) {
+			if (!std430)
+				align = align_up(align,16);
+			stride = align_up(size,align);
+			size = stride * m.count;
+		}
+		return true;
+	}
+
+	static void struct_layout(const scan_ctx_t& ctx,scan_struct_t& def,const bool std430) {
+		uint32_t offs = 0,max_align = std430 ? 1 : 16;
+
+		def.align[std430] = 0;
+		def.size[std430] = 0;
+		for (uint32_t i = def.first_member,j = def.first_member + def.member_count;i < j;++i) {
+			uint32_t align,size,stride,matrix_stride;
+			if (!member_layout(ctx.members[i],std430,align,size,stride,matrix_stride))
+				return;
+
+			offs = align_up(offs,align) + size;
+			max_align = std::max(max_align,align);
+		}
+
+		def.align[std430] = max_align;
+		def.size[std430] = align_up(offs,max_align);
+	}
+
+	//Appends m (struct members expanded) at offs,which is advanced past it
+	static void flatten_member(const scan_ctx_t& ctx,std::vector<jglsl_block_member_t>& out,const std::string& prefix,
+					const scan_member_t& m,const bool std430,uint32_t& offs) {
+		uint32_t align = 0,size = 0,stride = 0,matrix_stride = 0;
+		const bool known = (offs != jglsl_invalid_offset) && member_layout(m,std430,align,size,stride,matrix_stride);
+		const uint32_t base = known ? align_up(offs,align) : jglsl_invalid_offset;
+		const std::string name = prefix + m.name.str();
+		offs = known ? base + size : jglsl_invalid_offset;
+
+		if (!m.st) {
+			jglsl_block_member_t bm;
+			bm.name = name;
+			bm.type = m.type.str();
+			bm.offset = base;
+			bm.array_count = m.count;
+			bm.array_stride = stride;
+			bm.matrix_stride = matrix_stride;
+			bm.row_major = m.row_major;
+			out.push_back(bm);
+			return;
+		}
+
+		const uint32_t elems = ((m.count == 0) || (m.count == jglsl_invalid_offset)) ? 1 : m.count;
+		const uint32_t first = out.size();
+		for (uint32_t e = 0;e < elems;++e) {
+			char idx[16];
+			std::string field_prefix = name;
+			if (m.count != 1) {
+				sprintf(idx,"[%u]",e);
+				field_prefix += idx;
+			}
+			field_prefix += '.';
+
+			uint32_t field_offs = known ? base + e * stride : jglsl_invalid_offset;
+			for (uint32_t f = m.st->first_member,w = m.st->first_member + m.st->member_count;f < w;++f)
+				flatten_member(ctx,out,field_prefix,ctx.members[f],std430,field_offs);
+		}
+
+		//Runtime sized struct array ("buffer" blocks) : the fields of element k are k * stride further
+		if ((m.count == 0) && known) {
+			for (uint32_t i = first,j = out.size();i < j;++i) {
+				if (out[i].array_count == 1) {
+					out[i].array_count = 0;
+					out[i].array_stride = stride;
+				}
+			}
+		}
+	}
+
+	//toks[i] == "(" after layout,returns the index past ')'
+	static uint32_t scan_layout_qualifiers(const scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t i,scan_layout_t& ql) {
+		const uint32_t end = skip_group(toks,i,'(',')');
+
+		for (++i;i < end;++i) {
+			const jglsl_span_t& t = toks[i];
+			int32_t* value = (t == "location") ? &ql.location : (t == "binding") ? &ql.binding :
+							(t == "local_size_x") ? &ql.local_size[0] : (t == "local_size_y") ? &ql.local_size[1] :
+							(t == "local_size_z") ? &ql.local_size[2] : 0;
+
+			if (value && ((i + 2) < end) && (toks[i + 1] == "=")) {
+				uint32_t e = i + 2,k = i + 2,v;
+				while ((e < (end - 1)) && (toks[e] != ","))
+					e += (toks[e] == "(") ? skip_group(toks,e,'(',')') - e : 1;
+
+				if (eval_const_expr(ctx,toks,k,e,v) && (k == e))
+					*value = (int32_t)v;
+				i = e - 1;
+			} else if (t == "std140")
+				ql.packing = JGLSL_LAYOUT_STD140;
+			else if (t == "std430")
+				ql.packing = JGLSL_LAYOUT_STD430;
+			else if ((t == "shared") || (t == "packed"))
+				ql.packing = JGLSL_LAYOUT_SHARED;
+			else if (t == "row_major")
+				ql.row_major = 1;
+			else if (t == "column_major")
+				ql.row_major = 0;
+		}
+		return end;
+	}
+
+	//Blocks are usually declared by several stages,the first declaration is kept
+	static void add_block(std::vector<jglsl_uniform_block_t>& blocks,const jglsl_uniform_block_t& block) {
+		for (uint32_t i = 0,j = blocks.size();i < j;++i) {
+			if (blocks[i].name == block.name)
+				return;
+		}
+		blocks.push_back(block);
+	}
+
+	//toks[i] == "{" of an interface block,returns the index past its '}'
+	static uint32_t scan_block(scan_ctx_t& ctx,const std::vector<jglsl_span_t>& toks,uint32_t i,
+					jglsl_uniform_block_t& block,const bool row_major) {
+		const uint32_t n = toks.size();
+		const uint32_t mark = ctx.members.size();
+
+		for (++i;(i < n) && (toks[i] != "}");) {
+			scan_layout_t ql = { -1,row_major ? 1 : 0,-1,-1,{ -1,-1,-1 } };
+
+			for (;i < n;++i) {
+				if ((toks[i] == "layout") && ((i + 1) < n) && (toks[i + 1] == "("))
+					i = scan_layout_qualifiers(ctx,toks,i + 1,ql) - 1;
+				else if (!is_ignored_qualifier(toks[i]))
+					break;
+			}
+			if (i >= n)
+				break;
+
+			const jglsl_span_t& type = toks[i++];
+			const scan_struct_t* st = 0;
+			if (!ctx.is_builtin(type))
+				st = ctx.find(type);
+
+			i = scan_declarators(ctx,toks,i,type,st,false,&ctx.members,ql.row_major == 1);
+			i += (i < n) && (toks[i] == ";");
+		}
+
+		const bool std430 = block.layout == JGLSL_LAYOUT_STD430;
+		uint32_t offs = (block.layout == JGLSL_LAYOUT_SHARED) ? jglsl_invalid_offset : 0;
+		uint32_t max_align = std430 ? 1 : 16;
+
+		for (uint32_t m = mark,w = ctx.members.size();m < w;++m) {
+			uint32_t align,size,stride,matrix_stride;
+			if ((offs != jglsl_invalid_offset) && member_layout(ctx.members[m],std430,align,size,stride,matrix_stride))
+				max_align = std::max(max_align,align);
+			flatten_member(ctx,block.members,std::string(),ctx.members[m],std430,offs);
+		}
+		ctx.members.resize(mark);
+
+		block.size = (offs != jglsl_invalid_offset) ? align_up(offs,max_align) : jglsl_invalid_offset;
+		return (i < n) ? i + 1 : n;
+	}
+
+	/*
+		Consecutive locations from an explicit layout(location = N) for the n declarations just scanned.
+		Uniforms take one location per array element,vertex inputs the locations of their type
+		(one per matrix column,two per dvec3/dvec4 column).
+	*/
+	static void assign_locations(const scan_layout_t& ql,std::vector<uint32_t>& locations,const uint32_t n,
+					const std::vector<std::string>& types,const scan_field_t* fields,const uint32_t first,const bool input) {
+		uint32_t location = (uint32_t)ql.location;
+
+		for (uint32_t i = 0;i < n;++i) {
+			if (ql.location < 0) {
+				locations.push_back(jglsl_invalid_offset);
+				continue;
+			}
+
+			jglsl_vertex_attrib_t a;
+			const uint32_t count = ((fields[i].count == 0) || (fields[i].count == jglsl_invalid_offset)) ? 1 : fields[i].count;
+			const uint32_t used = (input && describe_vertex_type(types[first + i],a)) ? a.locations : 1;
+
+			locations.push_back(location);
+			location += count * used;
+		}
+	}
+
+	//Text left to scan once the defines are applied (the spans of defines must outlive ctx)
+	static jglsl_span_t preprocess_source(scan_ctx_t& ctx,const char* code,const uint32_t len,
+					const jglsl_define_set_t& defines) {
+		for (uint32_t i = 0,j = defines.names.size();i < j;++i) {
+			const jglsl_span_t name = { defines.names[i].c_str(),(uint32_t)defines.names[i].length() };
+			const jglsl_span_t value = { defines.values[i].c_str(),(uint32_t)defines.values[i].length() };
+			define_macro(ctx,name,value);
+		}
+		if ((!defines.empty()) || needs_preprocess(code,len))
+			return preprocess(ctx,code,len);
+
+		jglsl_span_t src = { code,len };
+		return src;
+	}
+
+	//Everything scan_source() looks at : tokens outside function bodies and the integral #defines
+	static uint64_t declaration_hash(const char* code,const uint32_t len,const jglsl_define_set_t& defines,
+					const jglsl_builtin_types_t& builtin_types) {
+		scan_ctx_t& ctx = scan_ctx_t::acquire(builtin_types);
+		std::vector<jglsl_span_t>& toks = ctx.toks;
+		const jglsl_span_t src = preprocess_source(ctx,code,len,defines);
+		uint64_t h = jglsl_fnv1a64(0,0);
+
+		tokenize(toks,src.ptr,src.len);
+		for (uint32_t i = 0,j = toks.size();i < j;++i) {
+			h = jglsl_fnv1a64(&toks[i].len,sizeof(toks[i].len),h);
+			h = jglsl_fnv1a64(toks[i].ptr,toks[i].len,h);
+		}
+		for (uint32_t i = 0,j = ctx.consts.size();i < j;++i) {
+			h = jglsl_fnv1a64(ctx.consts[i].name.ptr,ctx.consts[i].name.len,h);
+			h = jglsl_fnv1a64(&ctx.consts[i].value,sizeof(ctx.consts[i].value),h);
+		}
+		return h;
+	}
+
+	/*
+		Collects structs,uniforms,attributes and in/out declarations in a single pass over the token stream.
+		Only global scope is considered,function bodies are skipped.
+		stage : GL_*_SHADER ("in" of the vertex stage are attributes),0 if not known
+	*/
+	static void scan_source(scan_result_t& res,const GLenum stage,const char* code,const uint32_t len,
+					const jglsl_define_set_t& defines,
+					const jglsl_builtin_types_t& builtin_types) {
+		scan_ctx_t& ctx = scan_ctx_t::acquire(builtin_types);
+		std::vector<jglsl_span_t>& toks = ctx.toks;
+		const jglsl_span_t src = preprocess_source(ctx,code,len,defines);
+
+		toks.reserve(src.len / 4);	//No-op once the thread scanned a source this size
+		tokenize(toks,src.ptr,src.len);
+
+		//Reserve up front so pointers handed out by scan_struct stay valid
+		uint32_t struct_count = 0;
+		for (uint32_t i = 0,n = toks.size();i < n;++i)
+			struct_count += toks[i] == "struct";
+		ctx.structs.reserve(struct_count);
+
+		//Defaults set by "layout(...) uniform;" and "layout(...) buffer;"
+		uint32_t block_packing = JGLSL_LAYOUT_SHARED,storage_packing = JGLSL_LAYOUT_SHARED;
+		bool block_row_major = false,storage_row_major = false;
+
+		for (uint32_t i = 0,n = toks.size();i < n;) {
+			std::vector<std::string>* names = 0;
+			std::vector<std::string>* types = 0;
+			scan_layout_t ql = { -1,-1,-1,-1,{ -1,-1,-1 } };
+			bool is_const = false,is_buffer = false;
+
+			if (toks[i] == "{") { //Function body
+				i = skip_group(toks,i,'{','}');
+				continue;
+			}
+
+			if (toks[i] == "struct") {
+				const scan_struct_t* st;
+				i = scan_struct(ctx,toks,i,&st);
+				continue;
+			}
+
+			for (;i < n;++i) {
+				const uint8_t kw = scan_keyword(toks[i]);
+				if (kw == kw_layout) {
+					if (((i + 1) < n) && (toks[i + 1] == "("))
+						i = scan_layout_qualifiers(ctx,toks,i + 1,ql) - 1;
+				} else if (kw == kw_uniform) {
+					names = &res.uniforms;
+					types = &res.uniform_types;
+				} else if ((kw == kw_attribute) || ((kw == kw_in) && (stage == GL_VERTEX_SHADER))) {
+					names = &res.attributes;
+					types = &res.attribute_types;
+				} else if (kw == kw_in) {
+					names = &res.inputs;
+					types = &res.input_types;
+				} else if (kw == kw_out) {
+					names = &res.outputs;
+					types = &res.output_types;
+				} else if (kw == kw_const) {
+					is_const = true;
+				} else if (kw == kw_buffer) {
+					is_buffer = true;
+				} else if (kw != kw_ignored) {
+					break;
+				}
+			}
+
+			if (i >= n)
+				break;
+
+			if ((names == &res.uniforms) && (toks[i] == ";")) {
+				block_packing = (ql.packing >= 0) ? ql.packing : block_packing;
+				block_row_major = (ql.row_major >= 0) ? (ql.row_major == 1) : block_row_major;
+				++i;
+				continue;
+			}
+
+			if ((names == &res.inputs) && (toks[i] == ";")) { //layout(local_size_x = X,...) in;
+				if ((ql.local_size[0] >= 0) || (ql.local_size[1] >= 0) || (ql.local_size[2] >= 0)) {
+					for (uint32_t k = 0;k < 3;++k)
+						res.local_size[k] = (ql.local_size[k] >= 0) ? (uint32_t)ql.local_size[k] : 1;
+				}
+				++i;
+				continue;
+			}
+
+			if (is_buffer) {
+				if (toks[i] == ";") {
+					storage_packing = (ql.packing >= 0) ? ql.packing : storage_packing;
+					storage_row_major = (ql.row_major >= 0) ? (ql.row_major == 1) : storage_row_major;
+				} else if (((i + 1) < n) && (toks[i + 1] == "{")) {
+					jglsl_uniform_block_t block;
+					block.name = toks[i].str();
+					block.layout = (ql.packing >= 0) ? ql.packing : storage_packing;
+					block.index = GL_INVALID_INDEX;
+					block.binding = (ql.binding >= 0) ? (uint32_t)ql.binding : jglsl_invalid_offset;
+					i = scan_block(ctx,toks,i + 1,block,(ql.row_major >= 0) ? (ql.row_major == 1) : storage_row_major);
+					if ((i < n) && (toks[i] != ";"))
+						block.instance = toks[i].str();
+					add_block(res.storage_blocks,block);
+				}
+
+				while ((i < n) && (toks[i] != ";"))
+					++i;
+				i += (i < n);
+				continue;
+			}
+
+			if ((!names) && is_const && ((toks[i] == "int") || (toks[i] == "uint")))
+				i = scan_constants(ctx,toks,i);
+
+			if (!names) { //Not a declaration we care about
+				while ((i < n) && (toks[i] != ";") && (toks[i] != "{"))
+					i += (toks[i] == "(") ? skip_group(toks,i,'(',')') - i : 1;
+				i += (i < n) && (toks[i] == ";");
+				continue;
+			}
+
+			const scan_struct_t* st = 0;
+			jglsl_span_t type = toks[i];
+			if (type == "struct") {
+				i = scan_struct(ctx,toks,i,&st);
+			} else {
+				++i;
+				if (!ctx.is_builtin(type)) {
+					st = ctx.find(type);
+					if ((i < n) && (toks[i] == "{")) { //Interface block
+						if (names == &res.uniforms) {
+							jglsl_uniform_block_t block;
+							block.name = type.str();
+							block.layout = (ql.packing >= 0) ? ql.packing : block_packing;
+							block.index = GL_INVALID_INDEX;
+							block.binding = (ql.binding >= 0) ? (uint32_t)ql.binding : jglsl_invalid_offset;
+							i = scan_block(ctx,toks,i,block,(ql.row_major >= 0) ? (ql.row_major == 1) : block_row_major);
+							if ((i < n) && (toks[i] != ";"))
+								block.instance = toks[i].str();
+							add_block(res.blocks,block);
+						} else {
+							i = skip_group(toks,i,'{','}');
+						}
+						st = 0;
+					}
+					if (!st)
+						names = types = 0;
+				}
+			}
+
+			//Flattened onto the end of ctx.fields as scratch space,only the result gets its own strings
+			const uint32_t first = names ? names->size() : 0;
+			const uint32_t mark = ctx.fields.size(),names_mark = ctx.names.size();
+			i = scan_declarators(ctx,toks,i,type,st,names != 0);
+
+			if (names) {
+				for (uint32_t f = mark,w = ctx.fields.size();f < w;++f) {
+					const scan_field_t& field = ctx.fields[f];
+					names->emplace_back(&ctx.names[0] + field.name,field.name_len);
+					types->emplace_back(field.type.ptr,field.type.len);
+				}
+			}
+
+			const scan_field_t* fields = (ctx.fields.size() > mark) ? &ctx.fields[mark] : 0;
+			if (names == &res.uniforms) {
+				for (uint32_t f = mark,w = ctx.fields.size();f < w;++f) {
+					res.uniform_counts.push_back(ctx.fields[f].count);
+					res.uniform_bindings.push_back((ql.binding >= 0) ? (uint32_t)ql.binding : jglsl_invalid_offset);
+				}
+				assign_locations(ql,res.uniform_locations,names->size() - first,*types,fields,first,false);
+			} else if (names == &res.attributes) {
+				assign_locations(ql,res.attribute_locations,names->size() - first,*types,fields,first,true);
+			} else if (names == &res.inputs) {
+				assign_locations(ql,res.input_locations,names->size() - first,*types,fields,first,true);
+			}
+			ctx.fields.resize(mark);
+			ctx.names.resize(names_mark);
+			i += (i < n) && (toks[i] == ";");
+		}
+	}
+
+	public:
+
+	jglsl_shader_c() : m_builtin_types(&std_builtin_types()),m_own_builtin_types(0),m_precomputed(false),m_prog(jglsl_program_t::null_program()),m_registry(0),m_reflection_cache(0),
+		m_uniform_calls_issued(0),m_uniform_calls_skipped(0),m_batched(false),m_dsa(false),m_dsa_requested(false),m_persistent_sources(false),m_hot_reload(false),
+		m_specialized(0),m_handles_serial(0),m_handles_links(0),m_source_hash(jglsl_fnv1a64(0,0)),m_stage_bits(0),m_separable(false) {
+#ifdef JGLSL_PROFILE
+		m_frame_calls_mark = 0;
+		m_frame_binds = 0;
+		m_gpu_used[0] = m_gpu_used[1] = 0;
+		jglsl_profile_state().instances.push_back(this);
+#endif
+	}
+
+	~jglsl_shader_c() {
+		unload();
+#ifdef JGLSL_PROFILE
+		jglsl_profile_state_t& state = jglsl_profile_state();
+		if (state.active_owner == this)
+			jglsl_end_gpu_span();
+		state.instances.erase(std::remove(state.instances.begin(),state.instances.end(),this),state.instances.end());
+		for (uint32_t i = 0;i < 2;++i) {
+			if (!m_gpu_queries[i].empty())
+				glDeleteQueries(m_gpu_queries[i].size(),&m_gpu_queries[i][0]);
+		}
+#endif
+		delete m_own_builtin_types;
+	}
+
+	/*
+		Takes over the program,sources and settings of o,which is left unloaded.No GL calls are made,
+		so instances can live by value in containers that move them around (noexcept,so std::vector
+		relocates them by moving).Instances added to a jglsl_source_watch_c must stay where they are.
+	*/
+	jglsl_shader_c(jglsl_shader_c&& o) noexcept : jglsl_shader_c() {
+		swap(o);
+	}
+
+	jglsl_shader_c& operator=(jglsl_shader_c&& o) noexcept {
+		if (this != &o) {
+			unload();
+			swap(o);
+		}
+		return *this;
+	}
+
+	//Copies would release the same program twice
+	jglsl_shader_c(const jglsl_shader_c&) = delete;
+	jglsl_shader_c& operator=(const jglsl_shader_c&) = delete;
+
+	void swap(jglsl_shader_c& o) noexcept {
+		std::swap(m_builtin_types,o.m_builtin_types);
+		std::swap(m_own_builtin_types,o.m_own_builtin_types);
+		std::swap(m_pending,o.m_pending);
+		std::swap(m_precomputed,o.m_precomputed);
+		m_shaders.swap(o.m_shaders);
+		m_log_buffer.swap(o.m_log_buffer);
+		std::swap(m_prog,o.m_prog);
+		std::swap(m_registry,o.m_registry);
+		std::swap(m_reflection_cache,o.m_reflection_cache);
+		std::swap(m_uniform_calls_issued,o.m_uniform_calls_issued);
+		std::swap(m_uniform_calls_skipped,o.m_uniform_calls_skipped);
+		std::swap(m_batched,o.m_batched);
+		std::swap(m_dsa,o.m_dsa);
+		std::swap(m_dsa_requested,o.m_dsa_requested);
+		std::swap(m_stats,o.m_stats);
+#ifdef JGLSL_PROFILE
+		std::swap(m_frame_calls_mark,o.m_frame_calls_mark);
+		std::swap(m_frame_binds,o.m_frame_binds);
+		std::swap(m_gpu_used,o.m_gpu_used);
+		for (uint32_t i = 0;i < 2;++i)
+			m_gpu_queries[i].swap(o.m_gpu_queries[i]);
+
+		//The open span query moved along with its owner's query pool
+		jglsl_profile_state_t& state = jglsl_profile_state();
+		if (state.active_owner == this)
+			state.active_owner = &o;
+		else if (state.active_owner == &o)
+			state.active_owner = this;
+#endif
+		m_cache_dir.swap(o.m_cache_dir);
+		std::swap(m_persistent_sources,o.m_persistent_sources);
+		m_deferred.swap(o.m_deferred);
+		std::swap(m_hot_reload,o.m_hot_reload);
+		m_stages.swap(o.m_stages);
+		m_loaded_stages.swap(o.m_loaded_stages);
+		m_specializations.swap(o.m_specializations);
+		std::swap(m_specialized,o.m_specialized);
+		m_storage_buffers.swap(o.m_storage_buffers);
+		m_handle_names.swap(o.m_handle_names);
+		m_handle_locations.swap(o.m_handle_locations);
+		std::swap(m_handles_serial,o.m_handles_serial);
+		std::swap(m_handles_links,o.m_handles_links);
+		std::swap(m_source_hash,o.m_source_hash);
+		std::swap(m_stage_bits,o.m_stage_bits);
+		std::swap(m_separable,o.m_separable);
+		m_unchecked_shaders.swap(o.m_unchecked_shaders);
+	}
+
+	const char* get_log() const {
+		return m_log_buffer.empty() ? 0 : &m_log_buffer[0];
+	}
+		
+	//complex : the type matches any identifier containing it (ie "vec" for ivec3)
+	void register_builtin_type(const std::string& type,const bool complex) {
+		if (!m_own_builtin_types)
+			m_own_builtin_types = new jglsl_builtin_types_t(*m_builtin_types);
+		m_own_builtin_types->add(type,complex);
+		m_builtin_types = m_own_builtin_types;
+	}
+
+	void import_std_builtin_types() {
+		delete m_own_builtin_types;
+		m_own_builtin_types = 0;
+		m_builtin_types = &std_builtin_types();
+	}
+
+	void unload() {
+		drop_specialized();
+		release_program();
+		drop_sources();
+		drop_stages();
+		m_storage_buffers.clear();
+	}
+
+	/*
+		Shares programs with every other instance using the same registry (0 detaches).
+		While set load() only records sources like with a binary cache,compile errors are reported by finalize().
+		Applies from the next finalize() on.
+	*/
+	void set_registry(jglsl_program_registry_c* registry) {
+		m_registry = registry;
+	}
+
+	/*
+		Reuses scans of sources (per define set) already loaded by instances sharing the cache (0 detaches).
+		The cache is not locked,share it between instances used from one thread only.
+	*/
+	void set_reflection_cache(jglsl_reflection_cache_c* cache) {
+		m_reflection_cache = cache;
+	}
+
+	/*
+		Keeps every stage loaded from now on compiled,with its source and reflection,so reload() can
+		replace a single one.Programs are then neither shared through the registry nor binary cached.
+	*/
+	void set_hot_reload(const bool hot_reload) {
+		m_hot_reload = hot_reload;
+	}
+
+	inline bool is_hot_reload() const {
+		return m_hot_reload;
+	}
+
+	inline GLuint get_program() const {
+		return m_prog->id;
+	}
+
+	//Changes whenever the program is replaced (finalize(),reload(),specialized variants,unload())
+	inline uint64_t get_program_serial() const {
+		return m_prog->serial;
+	}
+
+	//True if other instances use the same program (uniform values set through one are seen by all)
+	inline bool is_shared() const {
+		return m_prog->refs > 1;
+	}
+
+	inline void bind() {
+		if (m_prog->link_pending)
+			complete_link();
+		refresh_stale_handles();
+
+		jglsl_use_program(m_prog->id);
+#ifdef JGLSL_PROFILE
+		begin_gpu_span();
+#endif
+		if (!m_prog->dirty_states.empty())
+			flush();
+	}
+
+	/*
+		bind() of a separable program used by a pipeline (see jglsl_pipeline_cache_c) : completes a pending
+		link and sends staged uniforms,the pipeline is bound instead of the program.
+	*/
+	inline void prepare_stages() {
+		if (m_prog->link_pending)
+			complete_link();
+		refresh_stale_handles();
+		if (!m_prog->dirty_states.empty())
+			flush();
+	}
+
+	/*
+		Links the stages of the next finalize() into a separable program (GL_PROGRAM_SEPARABLE),one
+		instance per stage variant,combined at draw time by jglsl_pipeline_cache_c.
+		Setters switch to glProgramUniform* as there is no single program in use,turning it off again
+		restores the set_direct_state_access() setting.
+		Needs GL 4.1 / ARB_separate_shader_objects,returns false otherwise.
+	*/
+	bool set_separable(const bool separable) {
+		m_separable = separable && jglsl_gl_caps().program_uniform;
+		m_dsa = m_dsa_requested || m_separable;
+		return m_separable == separable;
+	}
+
+	inline bool is_separable() const {
+		return m_separable;
+	}
+
+	//GL_*_SHADER_BIT of the stages in the program (for glUseProgramStages)
+	inline GLbitfield get_stage_bits() const {
+		return m_prog->stage_bits;
+	}
+
+	/*
+		Batched mode : setters only stage values,flush() (or the next bind()) sends the changed ones.
+		Without glProgramUniform* support flush() needs this program to be bound.
+	*/
+	void set_batched(const bool batched) {
+		if (m_batched && !batched)
+			flush();
+		m_batched = batched;
+	}
+
+	inline bool is_batched() const {
+		return m_batched;
+	}
+
+	/*
+		Setters use glProgramUniform* so uniforms of any number of programs can be updated without bind().
+		Needs GL 4.1 / ARB_separate_shader_objects,returns false (and keeps glUniform*) otherwise.
+	*/
+	bool set_direct_state_access(const bool dsa) {
+		m_dsa_requested = dsa && jglsl_gl_caps().program_uniform;
+		m_dsa = m_dsa_requested || m_separable;
+		return m_dsa_requested == dsa;
+	}
+
+	inline bool is_direct_state_access() const {
+		return m_dsa;
+	}
+
+	//Each dirty uniform goes out as a single call,arrays with their staged range of elements
+	void flush() const {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_UPLOADS);
+		for (uint32_t i = 0,j = m_prog->dirty_states.size();i < j;++i) {
+			uniform_state_t& st = m_prog->uniform_states[m_prog->dirty_states[i]];
+			if (st.dirty)
+				send_staged(st);
+		}
+
+		m_prog->dirty_states.clear();
+	}
+
+	inline void unbind() {
+		if (jglsl_bind_state().keep_bound)
+			return;
+
+		jglsl_use_program(0);
+#ifdef JGLSL_PROFILE
+		if (jglsl_profile_state().active_owner == this)
+			jglsl_end_gpu_span();
+#endif
+	}
+
+	//Phase timings and per frame counters (zeroes unless JGLSL_PROFILE is defined)
+	inline const jglsl_profile_stats_t& get_stats() const {
+		return m_stats;
+	}
+
+	inline void reset_stats() {
+		m_stats = jglsl_profile_stats_t();
+	}
+
+	//Called by jglsl_profile_end_frame() for every instance
+	void end_profile_frame(const uint32_t frame) {
+#ifdef JGLSL_PROFILE
+		m_stats.frame_uniform_calls = m_uniform_calls_issued - m_frame_calls_mark;
+		m_stats.frame_binds = m_frame_binds;
+		m_frame_calls_mark = m_uniform_calls_issued;
+		m_frame_binds = 0;
+
+		//Spans of the previous frame,their queries get reused by the next one.Results arrive in order,
+		//so the last one being available means all of them are and reading them does not stall
+		const uint32_t slot = (frame + 1) & 1;
+		const uint32_t used = m_gpu_used[slot];
+		GLint available = GL_TRUE;
+		if (used != 0)
+			glGetQueryObjectiv(m_gpu_queries[slot][used - 1],GL_QUERY_RESULT_AVAILABLE,&available);
+
+		if (available != GL_FALSE) {
+			uint64_t ns = 0;
+			for (uint32_t i = 0;i < used;++i) {
+				GLuint64 t = 0;
+				glGetQueryObjectui64v(m_gpu_queries[slot][i],GL_QUERY_RESULT,&t);
+				ns += t;
+			}
+			m_stats.gpu_ns = ns;
+			m_stats.gpu_spans = used;
+			m_stats.gpu_frame = frame - 1;
+		} else {
+			m_stats.gpu_dropped += used;
+		}
+		m_gpu_used[slot] = 0;
+#else
+		(void)frame;
+#endif
+	}
+
+	/*
+		Active vertex inputs of the linked program sorted by location.
+		Programs with equal get_vertex_layout_hash() values can share one VAO setup per vertex format.
+	*/
+	inline const std::vector<jglsl_vertex_attrib_t>& get_vertex_layout() const {
+		return m_prog->vertex_layout;
+	}
+
+	inline uint64_t get_vertex_layout_hash() const {
+		return m_prog->vertex_layout_hash;
+	}
+
+	inline uint32_t get_attribute(const std::string& attr) {
+		const uint32_t* location = m_prog->attributes.find(attr);
+		return location ? *location : 0;
+	}
+
+	/*
+		Handle to a uniform that stays valid across reload() and finalize(),get_uniform(handle) is
+		its location in the current program.Ask for handles once,each call adds a table entry.
+	*/
+	jglsl_uniform_handle_t get_uniform_handle(const std::string& uni) {
+		const jglsl_uniform_handle_t h = { (uint32_t)m_handle_names.size() };
+		m_handle_names.push_back(uni);
+		m_handle_locations.push_back(get_uniform(uni));
+		return h;
+	}
+
+	inline uint32_t get_uniform(const jglsl_uniform_handle_t h) const {
+		return m_handle_locations[h.index];
+	}
+
+	inline uint32_t get_uniform(const jglsl_uniform_key_t& uni) const {
+		const jglsl_name_table_t& table = m_prog->uniforms;
+		if (table.slots.empty())
+			return 0;
+
+		for (uint32_t i = uni.hash() & table.mask;;i = (i + 1) & table.mask) {
+			const uniform_slot_t& slot = table.slots[i];
+			if (slot.name == jglsl_invalid_offset)
+				return find_element(uni.name());
+			if ((slot.hash == uni.hash()) && (strcmp(table.get_name(slot),uni.name()) == 0))
+				return slot.value;
+		}
+	}
+
+	/*
+		Base location,element count and location stride of an array uniform.
+		"bones" for arrays of basic types (stride 1),"lights[0].f.a2" for a field of a struct array
+		(only the first "[0]" is walked).
+	*/
+	jglsl_uniform_array_t get_uniform_array(const std::string& name) const {
+		jglsl_uniform_array_t a = { 0,0,0 };
+		const uint32_t* it;
+		const std::string::size_type b = name.find("[0]");
+
+		if (b == std::string::npos) {
+			it = m_prog->uniforms.find(name);
+			if ((!it) || (*it == 0xFFFFFFFFu))
+				return a;
+
+			a.location = *it;
+			a.count = 1;
+			a.stride = 1;
+			if ((a.location < m_prog->location_states.size()) && (m_prog->location_states[a.location] != 0))
+				a.count = m_prog->uniform_states[m_prog->location_states[a.location] - 1].count;
+			return a;
+		}
+
+		const std::string head = name.substr(0,b + 1),tail = name.substr(b + 2);
+		bool even = true;
+
+		for (;;++a.count) {
+			char idx[16];
+			sprintf(idx,"%u",a.count);
+			it = m_prog->uniforms.find(head + idx + tail);
+			if (!it)
+				break;
+
+			if (a.count == 0)
+				a.location = *it;
+			else if (a.count == 1)
+				a.stride = *it - a.location;
+			else
+				even = even && (*it == (a.location + a.count * a.stride));
+			even = even && (*it != 0xFFFFFFFFu);
+		}
+
+		if (a.count == 1)
+			a.stride = 1;
+		if (!even)
+			a.stride = 0;
+		return a;
+	}
+
+	/*
+		Units finalize() gave the sampler and image uniforms of the sources (see resolve_texture_units()),
+		textures stay bound to them across programs instead of being rebound per draw.
+	*/
+	inline const std::vector<jglsl_texture_unit_t>& get_texture_units() const {
+		return m_prog->texture_units;
+	}
+
+	//Unit of a sampler/image uniform or of one of its array elements ("maps[2]"),jglsl_invalid_offset : none
+	uint32_t get_texture_unit(const jglsl_uniform_key_t& name) const {
+		const uint32_t location = get_uniform(name);
+		const std::vector<jglsl_texture_unit_t>& units = m_prog->texture_units;
+		for (uint32_t i = 0,j = units.size();i < j;++i) {
+			if ((location >= units[i].location) && (location < (units[i].location + units[i].count)))
+				return units[i].unit + (location - units[i].location);
+		}
+		return jglsl_invalid_offset;
+	}
+
+	//Binds texture to the unit of a sampler uniform,false if it has none
+	bool bind_texture(const jglsl_uniform_key_t& name,const GLenum target,const GLuint texture) const {
+		const uint32_t unit = get_texture_unit(name);
+		if (unit == jglsl_invalid_offset)
+			return false;
+
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(target,texture);
+		return true;
+	}
+
+	//Uniform blocks with their member layouts
+	inline uint32_t get_block_count() const {
+		return m_prog->blocks.size();
+	}
+
+	inline const jglsl_uniform_block_t* get_block(const uint32_t i) const {
+		return (i < m_prog->blocks.size()) ? &m_prog->blocks[i] : 0;
+	}
+
+	const jglsl_uniform_block_t* find_block(const std::string& name) const {
+		for (uint32_t i = 0,j = m_prog->blocks.size();i < j;++i) {
+			if (m_prog->blocks[i].name == name)
+				return &m_prog->blocks[i];
+		}
+		return 0;
+	}
+
+	//Assigns the buffer binding point a block reads from (see jglsl_ubo_ring_c)
+	bool bind_block(const std::string& name,const GLuint binding) {
+		const jglsl_uniform_block_t* b = find_block(name);
+		if ((!b) || (b->index == GL_INVALID_INDEX))
+			return false;
+
+		glUniformBlockBinding(m_prog->id,b->index,binding);
+		return true;
+	}
+
+	/*
+		Per-draw record layout of the runtime sized array closing a std140/std430 storage block,
+		false if the block has none.Elements of basic types have a single field named after the array.
+	*/
+	bool get_draw_layout(const std::string& block,jglsl_draw_layout_t& out) const {
+		const jglsl_uniform_block_t* b = find_storage_block(block);
+		out.fields.clear();
+		if ((!b) || (b->binding == jglsl_invalid_offset))
+			return false;
+
+		//Flattened fields of the array share its "name[0]." prefix
+		uint32_t first = 0;
+		while ((first < b->members.size()) && (b->members[first].array_count != 0))
+			++first;
+		if ((first == b->members.size()) || (b->members[first].offset == jglsl_invalid_offset))
+			return false;
+
+		const std::string& head = b->members[first].name;
+		const std::string::size_type dot = head.find("[0].");
+		const std::string prefix = (dot != std::string::npos) ? head.substr(0,dot + 4) : std::string();
+
+		out.binding = b->binding;
+		out.offset = b->members[first].offset;
+		out.stride = b->members[first].array_stride;
+		for (uint32_t i = first,j = b->members.size();i < j;++i) {
+			jglsl_block_member_t f = b->members[i];
+			if (prefix.empty()) { //Array of a basic type
+				f.offset = 0;
+				f.array_count = 1;
+				f.array_stride = 0;
+				out.fields.push_back(f);
+				break;
+			}
+			if (f.name.compare(0,prefix.size(),prefix) != 0)
+				break;
+
+			f.name = f.name.substr(prefix.size());
+			f.offset -= out.offset;
+			if (f.array_count == 0) {
+				f.array_count = 1;
+				f.array_stride = 0;
+			}
+			out.fields.push_back(f);
+		}
+		return out.stride != 0;
+	}
+
+	//Shader storage ("buffer") blocks,bindings are assigned at link time when the sources give none
+	inline uint32_t get_storage_block_count() const {
+		return m_prog->storage_blocks.size();
+	}
+
+	inline const jglsl_uniform_block_t* get_storage_block(const uint32_t i) const {
+		return (i < m_prog->storage_blocks.size()) ? &m_prog->storage_blocks[i] : 0;
+	}
+
+	const jglsl_uniform_block_t* find_storage_block(const std::string& name) const {
+		for (uint32_t i = 0,j = m_prog->storage_blocks.size();i < j;++i) {
+			const jglsl_uniform_block_t& b = m_prog->storage_blocks[i];
+			if ((b.name == name) || (b.instance == name))
+				return &b;
+		}
+		return 0;
+	}
+
+	bool bind_storage_block(const std::string& name,const GLuint binding) {
+		jglsl_uniform_block_t* b = const_cast<jglsl_uniform_block_t*>(find_storage_block(name));
+		if ((!b) || (b->index == GL_INVALID_INDEX))
+			return false;
+
+		glShaderStorageBlockBinding(m_prog->id,b->index,binding);
+		b->binding = binding;
+		refresh_storage_buffers();
+		return true;
+	}
+
+	/*
+		Buffer (range) backing a storage block,bound to the block's binding by bind_storage_buffers() and dispatch().
+		Kept across reload() (skipped while the program lacks the block),dropped by unload().
+		size : 0 binds the whole buffer
+	*/
+	bool set_storage_buffer(const std::string& block,const GLuint buffer,const GLintptr offset = 0,const GLsizeiptr size = 0) {
+		const jglsl_uniform_block_t* b = find_storage_block(block);
+		if ((!b) || (b->index == GL_INVALID_INDEX))
+			return false;
+
+		const storage_buffer_t sb = { b->name,b->binding,buffer,offset,size };
+		for (uint32_t i = 0,j = m_storage_buffers.size();i < j;++i) {
+			if (m_storage_buffers[i].block == sb.block) {
+				m_storage_buffers[i] = sb;
+				return true;
+			}
+		}
+		m_storage_buffers.push_back(sb);
+		return true;
+	}
+
+	void bind_storage_buffers() const {
+		for (uint32_t i = 0,j = m_storage_buffers.size();i < j;++i) {
+			const storage_buffer_t& sb = m_storage_buffers[i];
+			if (sb.binding == jglsl_invalid_offset)
+				continue;
+			if (sb.size == 0)
+				glBindBufferBase(GL_SHADER_STORAGE_BUFFER,sb.binding,sb.buffer);
+			else
+				glBindBufferRange(GL_SHADER_STORAGE_BUFFER,sb.binding,sb.buffer,sb.offset,sb.size);
+		}
+	}
+
+	//Workgroup size of a compute program (all 0 otherwise)
+	inline const uint32_t* get_local_size() const {
+		return m_prog->local_size;
+	}
+
+	//Workgroups covering x * y * z invocations (rounded up to whole groups)
+	jglsl_dispatch_args_t get_dispatch_args(const uint32_t x,const uint32_t y = 1,const uint32_t z = 1) const {
+		const uint32_t* ls = m_prog->local_size;
+		jglsl_dispatch_args_t a;
+		a.num_groups_x = ls[0] ? (x + ls[0] - 1) / ls[0] : 0;
+		a.num_groups_y = ls[1] ? (y + ls[1] - 1) / ls[1] : 0;
+		a.num_groups_z = ls[2] ? (z + ls[2] - 1) / ls[2] : 0;
+		return a;
+	}
+
+	//Stores get_dispatch_args() into buffer at offset for dispatch_indirect()
+	void write_dispatch_args(const GLuint buffer,const GLintptr offset,const uint32_t x,const uint32_t y = 1,const uint32_t z = 1) const {
+		const jglsl_dispatch_args_t a = get_dispatch_args(x,y,z);
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER,buffer);
+		glBufferSubData(GL_DISPATCH_INDIRECT_BUFFER,offset,sizeof(a),&a);
+	}
+
+	/*
+		Binds the program and the storage buffers,then dispatches the given workgroup counts.
+		barriers : glMemoryBarrier() bits issued after the dispatch (0 : none)
+	*/
+	void dispatch(const GLuint groups_x,const GLuint groups_y = 1,const GLuint groups_z = 1,const GLbitfield barriers = 0) {
+		bind();
+		bind_storage_buffers();
+		glDispatchCompute(groups_x,groups_y,groups_z);
+		if (barriers)
+			glMemoryBarrier(barriers);
+	}
+
+	//dispatch() of enough workgroups for x * y * z invocations
+	void dispatch_threads(const uint32_t x,const uint32_t y = 1,const uint32_t z = 1,const GLbitfield barriers = 0) {
+		const jglsl_dispatch_args_t a = get_dispatch_args(x,y,z);
+		dispatch(a.num_groups_x,a.num_groups_y,a.num_groups_z,barriers);
+	}
+
+	//Workgroup counts read from buffer at offset (see write_dispatch_args())
+	void dispatch_indirect(const GLuint buffer,const GLintptr offset = 0,const GLbitfield barriers = 0) {
+		bind();
+		bind_storage_buffers();
+		glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER,buffer);
+		glDispatchComputeIndirect(offset);
+		if (barriers)
+			glMemoryBarrier(barriers);
+	}
+
+	//type : builtin GLSL type,describes the input in get_vertex_layout() (empty : left out)
+	inline void add_attribute(const std::string& attr,const std::string& type = std::string()) {
+		if ((m_prog == jglsl_program_t::null_program()) || m_prog->attributes.find(attr))
+			return;
+		insert_attribute(attr,glGetAttribLocation(m_prog->id,attr.c_str()),type);
+	}
+
+	void insert_attribute(const std::string& attr,const uint32_t location,const std::string& type) {
+		if ((!m_prog->attributes.insert(attr,location)) || (location == 0xFFFFFFFFu))
+			return;
+
+		jglsl_vertex_attrib_t a;
+		if (describe_vertex_type(type,a)) {
+			a.name = attr;
+			a.location = location;
+			m_prog->vertex_layout.push_back(a);
+		}
+	}
+
+	//Format,components,columns and locations of a vertex input type ("vec3","ivec4","dmat4x3"...)
+	static bool describe_vertex_type(const std::string& type,jglsl_vertex_attrib_t& a) {
+		if (!describe_vertex_components(type,a))
+			return false;
+
+		//More than two doubles per column need two locations
+		a.locations = a.columns * (((a.format == GL_DOUBLE) && (a.components > 2)) ? 2 : 1);
+		return true;
+	}
+
+	static bool describe_vertex_components(const std::string& type,jglsl_vertex_attrib_t& a) {
+		const char* p = type.c_str();
+		a.format = GL_FLOAT;
+		a.components = 1;
+		a.columns = 1;
+
+		if ((type == "float") || (type == "int") || (type == "uint") || (type == "double")) {
+			a.format = (*p == 'f') ? GL_FLOAT : (*p == 'i') ? GL_INT : (*p == 'u') ? GL_UNSIGNED_INT : GL_DOUBLE;
+			return true;
+		}
+
+		if (*p == 'd')
+			a.format = GL_DOUBLE;
+		else if (*p == 'i')
+			a.format = GL_INT;
+		else if (*p == 'u')
+			a.format = GL_UNSIGNED_INT;
+		p += (a.format != GL_FLOAT);
+
+		if ((strncmp(p,"vec",3) == 0) && (p[3] >= '2') && (p[3] <= '4') && (p[4] == 0)) {
+			a.components = p[3] - '0';
+			return true;
+		}
+
+		if (((a.format == GL_FLOAT) || (a.format == GL_DOUBLE)) && (strncmp(p,"mat",3) == 0) && (p[3] >= '2') && (p[3] <= '4')) {
+			a.columns = p[3] - '0';
+			a.components = a.columns;
+			if (p[4] == 0)
+				return true;
+			if ((p[4] == 'x') && (p[5] >= '2') && (p[5] <= '4') && (p[6] == 0)) {
+				a.components = p[5] - '0';
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static bool vertex_attrib_less(const jglsl_vertex_attrib_t& a,const jglsl_vertex_attrib_t& b) {
+		return a.location < b.location;
+	}
 
+	//Sorted by location,the hash only covers what a VAO depends on (locations,formats,not names)
+	void finish_vertex_layout() {
+		std::vector<jglsl_vertex_attrib_t>& layout = m_prog->vertex_layout;
+		std::sort(layout.begin(),layout.end(),vertex_attrib_less);
 
-	shader->finalize(); 	//Will link shaders & resolve all symbol addresses
+		uint64_t h = jglsl_fnv1a64(0,0);
+		for (uint32_t i = 0,j = layout.size();i < j;++i) {
+			const uint32_t v[4] = { layout[i].location,(uint32_t)layout[i].components,layout[i].format,layout[i].columns };
+			h = jglsl_fnv1a64(v,sizeof(v),h);
+		}
+		m_prog->vertex_layout_hash = h;
+	}
 
-	if (shader->get_log())
-		printf("Log : %s\n",shader->get_log());
+	/*
+		type : builtin GLSL type,used to size the shadow copy (empty : do not cache)
+		count : array size (jglsl_invalid_offset : ask GL),the whole array is shadowed when its locations are consecutive
+	*/
+	inline void add_uniform(const std::string& uni,const std::string& type = std::string(),uint32_t count = 1) {
+		if ((m_prog == jglsl_program_t::null_program()) || m_prog->uniforms.find(uni))
+			return;
 
-	uint32_t some_attr_location = shader->get_attribute("a_var");
-	uint32_t some_uni_location = shader->get_uniform("u_var");
+		const uint32_t location = glGetUniformLocation(m_prog->id,uni.c_str());
+		if (count == jglsl_invalid_offset)
+			count = query_array_size(uni);
 
+		if ((count > 1) && (location != 0xFFFFFFFFu)) {
+			char idx[16];
+			sprintf(idx,"[%u]",count - 1);
+			if ((uint32_t)glGetUniformLocation(m_prog->id,(uni + idx).c_str()) != (location + count - 1))
+				count = 1;	//Trimmed or scattered by the driver,only the first element is shadowed
+		}
 
-	//Structure access :
-	glsl shader :
-	struct var3_t { int a2; int b2; int c2; }
-	struct var_t { int a; int b; int c; var3_t f; }
-	struct var2_t {var_t other; int d; int e; }
+		insert_uniform(uni,location,type,count);
+	}
 
-	uniform var2_t test;
-	...
+	//Array elements of basic types are at consecutive locations from location
+	void insert_uniform(const std::string& uni,const uint32_t location,const std::string& type,const uint32_t count) {
+		if (!m_prog->uniforms.insert(uni,location))
+			return;
 
+		add_uniform_state(location,type,std::max(count,1u));
+	}
 
-	To access test.other.a; do :
-	uint32_t some_uni_location = shader->get_uniform("test.other.a");
+	/*
+		Enables the on-disk program binary cache (empty string disables it).
+		While enabled load() only records sources,compile errors are reported by finalize().
+	*/
+	void set_binary_cache_dir(const std::string& dir) {
+		m_cache_dir = dir;
+	}
 
-	To access test.other.f.a2; do :
-	uint32_t some_uni_location = shader->get_uniform("test.other.f.a2");
+	/*
+		Sources are only read within [code,code + len),they need no NUL terminator.
+		Set this when the buffers given to load() stay valid until finalize() (ie slices of a mapped file),
+		deferred sources are then referenced instead of copied.
+	*/
+	void set_persistent_sources(const bool persistent) {
+		m_persistent_sources = persistent;
+	}
 
-	To access test.e; do :
-	uint32_t some_uni_location = shader->get_uniform("test.e");
+	inline bool is_persistent_sources() const {
+		return m_persistent_sources;
+	}
 
-	To modify location by name do :
-	shader->u_s32("test.other.f.a2",0);
+	/*
+		Serialized uniform/attribute tables of the given sources.Pure CPU work,usable offline without a context.
+		types : stage of every source (needed for vertex "in" declarations),0 if not known
+		defines : permutation the sources are loaded with
+	*/
+	void reflect_sources(const char* const* codes,const uint32_t* lens,const uint32_t count,std::vector<uint8_t>& out,
+					const GLenum* types = 0,const jglsl_define_set_t& defines = jglsl_define_set_t::none()) const {
+		static thread_local scan_result_t res;	//Keeps its storage for the next call of the thread
+		res.clear();
+		for (uint32_t i = 0;i < count;++i)
+			scan_source(res,types ? types[i] : 0,codes[i],lens[i],defines,*m_builtin_types);
+		serialize_reflection(res,out);
+	}
 
-	To modify location by index do :
-	shader->u_s32(some_uni_location,0);
-*/
+	//Declarations of one source added to res,reflect_sources() without the serialization
+	void reflect_source(jglsl_scan_result_t& res,const GLenum type,const char* code,const uint32_t len,
+					const jglsl_define_set_t& defines = jglsl_define_set_t::none()) const {
+		scan_source(res,type,code,len,defines,*m_builtin_types);
+	}
 
-class jglsl_shader_c {
-	private:
-	std::map<std::string,uint32_t> m_attributes; 
-	std::map<std::string,uint32_t> m_uniforms;
-	std::vector<std::string> m_builtin_types;			//Standard builtin types (scanned by match-case)
-	std::vector<std::string> m_complex_builtin_types;	//Special builtin types (scanned by pattern)
-	std::vector<std::string> m_pending_uniforms;
-	std::vector<std::string> m_pending_attributes;
-	std::vector<GLuint> m_shaders;
-	std::vector<char> m_log_buffer;
-	GLuint m_program;
-
-	//The parser can be improved with pointer math ,  although its highly unlikely to cause a bottleneck
-	//Note:Parsing code has been defined as static to avoid generating all that garbage code within the class
-	static uint32_t skip_ws(const char* code,const uint32_t offs,const uint32_t len) {
-		uint32_t ptr = offs;
-		bool done = false;
-
-		while ( (!done) && (ptr < len) ) {
-			done = true;
-
-			//Whitespace first
-			while ((ptr < len) && isspace(code[ptr]))
-				++ptr;
-
-			//Skip comments
-			if (((ptr+1) < len) && (code[ptr] == '/')) {
-				if ((code[ptr+1] == '/')) {
-					++ptr;
-					while ((ptr < len) && ((code[ptr] != '\n') || (code[ptr] != '\r')))
-						++ptr;
-				} else if ((code[ptr+1] == '*')) { 
-					ptr += 2;
-					while ((ptr+1 < len) && ( (code[ptr] != '*') && (code[ptr+1] != '/')))
-						++ptr;
-					if ((ptr+1 < len) && ( (code[ptr] == '*') && (code[ptr+1] == '/')))
-						ptr += 2;
-				}
+	/*
+		Uses tables produced by reflect_sources() for the following load() calls instead of parsing the sources.
+		Declarations of stages loaded before are kept,the tables are added to them.
+	*/
+	bool set_precomputed_reflection(const uint8_t* data,const uint32_t len) {
+		scan_result_t res;
+		uint32_t offs = 0;
+		if (!deserialize_reflection(res,data,len,offs))
+			return false;
 
-				done = false;
-			}
- 		}
+		m_pending.append(res);
+		m_precomputed = true;
+		return true;
+	}
 
-		return ptr;
+	/*
+		Compiles without waiting for the result,the status is collected by finalize()/poll()
+		defines : inserted after the #version line.Reflection only covers declarations the
+		#if/#ifdef blocks leave in (object-like macros are evaluated,types are not macro expanded).
+	*/
+	bool load_async(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines) {
+		return submit_stage(type,code,len,defines,0,true);
 	}
 
-	static uint32_t next_tok(std::string& tok,const char* code,const uint32_t offs,const uint32_t len) {
-		uint32_t ptr = offs;
-		tok.clear();
+	bool load_async(const GLenum type,const char* code,const uint32_t len) {
+		return load_async(type,code,len,jglsl_define_set_t::none());
+	}
 
-		while ((ptr < len) && (!isspace(code[ptr])) && (code[ptr] != ';') && (code[ptr] != '{') && (code[ptr] != '}')
-			 && (code[ptr] != ',')  && (code[ptr] != '/') && (code[ptr] != '[') )
-			tok += code[ptr++];
+	bool load_async(const GLenum type,const std::string& code) {
+		return load_async(type,code.c_str(),code.length());
+	}
 
-		return ptr;
+	bool load_async(const GLenum type,const jglsl_span_t& code) {
+		return load_async(type,code.ptr,code.len);
 	}
 
-	static bool is_builtin_type(const std::string& s,
-					const std::vector<std::string>& base_types,
-					const std::vector<std::string>& complex_types) {
-		for (uint32_t i = 0,j = base_types.size();i < j;++i) {
-			if (s == base_types[i])
-				return true;
-		}
+	bool load(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines) {
+		return submit_stage(type,code,len,defines,0,false);
+	}
 
-		for (uint32_t i = 0,j = complex_types.size();i < j;++i) {
-			if (s.find(complex_types[i]) != std::string::npos)
-				return true;
-		}
+	bool load(const GLenum type,const char* code,const uint32_t len) {
+		return load(type,code,len,jglsl_define_set_t::none());
+	}
 
-		return false;
+	bool load(const GLenum type,const std::string& code,const jglsl_define_set_t& defines) {
+		return load(type,code.c_str(),code.length(),defines);
 	}
-	
-	static std::vector<std::string>* get_struct_field(const std::string& name,std::map<std::string,std::vector<std::string> >& structs) {
-		std::map<std::string,std::vector<std::string> >::iterator it = structs.find(name);
-		return (it != structs.end()) ? &it->second : 0;
+
+	bool load(const GLenum type,const std::string& code) {
+		return load(type,code.c_str(),code.length());
 	}
 
-	//Fill up structure list and also handle structure->structure access
-	static void parse_structures(std::map<std::string,std::vector<std::string> >& structs,const char* code,const uint32_t len,
-					const std::vector<std::string>& base_types,
-					const std::vector<std::string>& complex_types) {
-		const char* pcode = code;
-		std::string tok;
+	bool load(const GLenum type,const jglsl_span_t& code) {
+		return load(type,code.ptr,code.len);
+	}
 
-		for (uint32_t offs = 0;offs < len;) {
-	 
-			std::string field_name;
-			std::vector<std::string> field_fields;
+	/*
+		Scans a stage without touching GL or this instance (the reflection cache is not used),
+		safe on worker threads as long as no register_builtin_type()/import_std_builtin_types() runs meanwhile.
+	*/
+	void prepare(const GLenum type,const char* code,const uint32_t len,jglsl_prepared_stage_t& out,
+					const jglsl_define_set_t& defines = jglsl_define_set_t::none()) const {
+		out.type = type;
+		out.code.assign(code,len);
+		out.defines = defines;
+		out.reflection.clear();
+		scan_source(out.reflection,type,code,len,defines,*m_builtin_types);
+	}
 
-			pcode = strstr(pcode,"struct");
-			if (0==pcode)
-				break;
- 
-			offs = skip_ws(code, (ptrdiff_t)(pcode - code) + 6,len);
-			if (offs>=len)
-				return;
+	void prepare(const GLenum type,const std::string& code,jglsl_prepared_stage_t& out,
+					const jglsl_define_set_t& defines = jglsl_define_set_t::none()) const {
+		prepare(type,code.c_str(),code.length(),out,defines);
+	}
 
-			offs = next_tok(field_name,code,offs,len);
-			if (offs>=len)
-				return;
-			
-			offs = skip_ws(code,offs,len);
-			if (offs>=len)
-				return;
+	/*
+		GL thread side of prepare() : load()/load_async() without parsing the source.
+		With persistent sources the stage is referenced until finalize().
+	*/
+	bool commit(const jglsl_prepared_stage_t& stage,const bool async = false) {
+		return submit_stage(stage.type,stage.code.c_str(),stage.code.length(),stage.defines,&stage.reflection,async);
+	}
 
-			if (code[offs] != '{') //error
-				return;
-	
-			offs = skip_ws(code,offs + 1,len);
-			if (offs>=len)
-				return;
+	//Starts linking without waiting for the result.Use poll()/is_ready() before touching uniforms
+	bool finalize_async() {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_FINALIZE);
+		if (m_shaders.empty() && m_deferred.empty()) {
+			append_log("finalize() : No GLSL compiled shaders found!\n");
+			return false;
+		}
 
- 			std::vector<std::string>* struct_fld = 0;
-			while ((offs < len)) {
-				offs = skip_ws(code,offs,len);
-				if (offs>=len)
-					break;
-				if (code[offs] == '}')
-					break;
-		
-				offs = next_tok(tok,code,offs,len);
-				if (is_builtin_type(tok,base_types,complex_types)) {
-					offs = skip_ws(code,offs ,len);
-					if (offs >= len)
-						break;
+		if (m_prog != jglsl_program_t::null_program()) {
+			char tmp[256];
 
-					offs = next_tok(tok,code,offs,len);
-					field_fields.push_back(tok); 
-				} 
-				else if ( struct_fld = get_struct_field(tok,structs))  { //Handle struct within struct
-					offs = skip_ws(code,offs ,len);
-					if (offs >= len)
-						break;
+			sprintf(tmp,"finalize() : Warning previous program(%u) is still active.\nShutting it down..\n",m_prog->id);
+			append_log(tmp);
+			release_program();
+		}
 
-					offs = next_tok(tok,code,offs,len);
-					for (uint32_t f = 0,w = struct_fld->size();f < w;++f) {
-						field_fields.push_back(tok + "." + struct_fld->at(f) ); 
-						//printf("s->sadd [%s]\n",field_fields.back().c_str());
-					}
-				} else {
-					field_fields.push_back(tok); 
-					//printf("s->sadd [%s]\n",field_fields.back().c_str());
-				}
-				offs = skip_ws(code,offs ,len);
-				if (offs >= len)
-					break;
+		const bool cached = use_binary_cache();
+		const uint64_t key = m_separable ? jglsl_fnv1a64("separable",9,m_source_hash) : m_source_hash;
+		const std::string path = cached ? cache_path(key) : std::string();
 
-				if (code[offs] == ',')
-					++offs;
-				else if (code[offs] == ';')
-					++offs;
-				else if (code[offs] == '[') {
-					++offs;
-					while ((offs < len) && (code[offs] != ']'))
-						++offs;
-					if (offs < len)
-						offs += code[offs] == ']';
-				}
+		if (use_registry()) {
+			jglsl_program_t* prog = m_registry->acquire(key);
+			if (prog) {
+				m_prog = prog;
+				drop_sources();
+				refresh_handles();
+				return true;
 			}
+		}
 
-			if ((offs < len) && (code[offs] == '}'))
-				structs.insert(std::pair<std::string,std::vector<std::string> >(field_name,field_fields));
+		m_prog = new jglsl_program_t();
+		m_prog->refs = 1;
+		m_prog->key = key;
+		m_prog->stage_bits = m_stage_bits;
+		m_prog->link_pending = true;
+		if (use_registry())
+			m_registry->insert(m_prog);
 
-			pcode = &code[offs + 2];
-			if (pcode >= &code[len])
-				return;
+		if (cached && load_binary_cache(path)) {
+			drop_sources();	//Already compiled stages are simply dropped
+			return true;
+		}
+
+		for (uint32_t i = 0,j = m_deferred.size();i < j;++i) {
+			const jglsl_span_t src = m_deferred[i].data();
+			compile_stage(m_deferred[i].type,src.ptr,src.len,m_deferred[i].defines,
+					m_deferred[i].prepared ? &m_deferred[i].reflection : 0);
+		}
+		m_deferred.clear();
+
+		//The program takes over the stages and the reflection until the link completes
+		m_prog->shaders.swap(m_shaders);
+		m_prog->unchecked_shaders.swap(m_unchecked_shaders);
+		std::swap(m_prog->reflection,m_pending);
+		if (m_hot_reload) {
+			drop_stages();
+			m_stages.swap(m_loaded_stages);
+		}
+		drop_sources();
+
+		m_prog->id = glCreateProgram();
+		if (m_separable)
+			glProgramParameteri(m_prog->id,GL_PROGRAM_SEPARABLE,GL_TRUE);
+		if (cached) {
+			glProgramParameteri(m_prog->id,GL_PROGRAM_BINARY_RETRIEVABLE_HINT,GL_TRUE);
+			m_prog->binary_path = path;
 		}
+
+		for (uint32_t i = 0,j = m_prog->shaders.size();i < j;++i)
+			glAttachShader(m_prog->id,m_prog->shaders[i]);
+
+		//Kept stages stay alive for reload()
+		if (m_hot_reload)
+			m_prog->shaders.clear();
+
+		glLinkProgram(m_prog->id);
+		return true;
 	}
 
-	static void parse_vars(std::vector<std::string>& res,const std::string& field_name,const char* code,const uint32_t len,
-					const std::vector<std::string>& base_types,
-					const std::vector<std::string>& complex_types) {
-		const char* pcode = code;
-		std::string tok;
-		const uint32_t field_size = field_name.length();
- 
-		std::map<std::string,std::vector<std::string> > structs;
-		parse_structures(structs,code,len,base_types,complex_types);
- 
-		for (uint32_t offs = 0;offs < len;) {
-			pcode = strstr(pcode,field_name.c_str());
-			if (0==pcode)
-				break;
- 
-			offs = (ptrdiff_t)(pcode - code );
- 			pcode += field_size;
- 
-			uint32_t o = (ptrdiff_t)(pcode - code);
-			uint32_t l = len;
-			
-			//for (;o < l;++o)printf("%c",code[o]); printf("\n");	 
-			std::vector<std::string>* struct_fld = 0;
-
-			o = skip_ws(code,o,l);
-			if (o >= l)
-				break;
+	/*
+		Recompiles one stage of a program loaded with set_hot_reload() on and relinks it,the other
+		stages are attached as compiled.The stage is only scanned again if its declarations changed.
+		Handles (get_uniform_handle()) follow the new locations,uniform values start over.
+		On compile or link errors the current program stays in use.
+	*/
+	bool reload(const GLenum type,const char* code,const uint32_t len,const jglsl_define_set_t& defines = jglsl_define_set_t::none()) {
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_LOAD);
+		uint32_t s = 0;
+		while ((s < m_stages.size()) && (m_stages[s].type != type))
+			++s;
 
-			o = next_tok(tok,code,o,l);
-			if (!is_builtin_type(tok,base_types,complex_types)) {			
-				struct_fld = get_struct_field(tok,structs);
-				if (!struct_fld) 
-					continue;
-			}
-			//printf("add [%s]\n",tok.c_str());
-			while (o < l) {
-				o = skip_ws(code,o,l);
-				if (o >= l)
-					break;
-				else if (code[o] == ';')
-					break;
-				o = next_tok(tok,code,o,l);
+		if (s == m_stages.size()) {
+			append_log("reload() : Stage was not loaded with hot reload on\n");
+			return false;
+		}
 
-				if (struct_fld)	{
-					for (uint32_t f = 0,w = struct_fld->size();f < w;++f) {
-						res.push_back(tok + "." + struct_fld->at(f) ); 
-						//printf("add [%s]\n",res.back().c_str());
-					}
-				}
-				else {
-					res.push_back(tok); 
-					//printf("add [%s]\n",res.back().c_str());
-				}
-				o = skip_ws(code,o ,l);
-				if (o >= l)
-					break;
+		const GLuint shader = create_shader(type,code,len,defines);
+		if (!check_shader(shader)) {
+			glDeleteShader(shader);
+			return false;
+		}
 
-				if (code[o] == ',')
-					++o;
-				else if (code[o] == '[') {
-					++o;
-					while ((o < l) && (code[o] != ']'))
-						++o;
-					if (o < l)
-						o += code[o] == ']';
-				}
-			}
-			pcode = &code[o];
+		scan_result_t reflection;
+		const uint64_t decl_hash = declaration_hash(code,len,defines,*m_builtin_types);
+		const bool rescan = decl_hash != m_stages[s].decl_hash;
+		if (rescan) {
+			JGLSL_PROFILE_PHASE(JGLSL_PHASE_PARSE);
+			scan_source(reflection,type,code,len,defines,*m_builtin_types);
 		}
 
- 		// while(1);
-	}
+		jglsl_program_t* prog = new jglsl_program_t();
+		prog->refs = 1;
+		prog->key = jglsl_fnv1a64(0,0);
+		prog->stage_bits = m_prog->stage_bits;
+		prog->link_pending = true;
+		prog->id = glCreateProgram();
+		if (m_separable)
+			glProgramParameteri(prog->id,GL_PROGRAM_SEPARABLE,GL_TRUE);
 
-	public:
+		for (uint32_t i = 0,j = m_stages.size();i < j;++i) {
+			const kept_stage_t& st = m_stages[i];
+			if (i == s) {
+				glAttachShader(prog->id,shader);
+				prog->key = stage_hash(type,code,len,defines,prog->key);
+				prog->reflection.append(rescan ? reflection : st.reflection);
+			} else {
+				glAttachShader(prog->id,st.shader);
+				prog->key = stage_hash(st.type,st.code.c_str(),st.code.length(),st.defines,prog->key);
+				prog->reflection.append(st.reflection);
+			}
+		}
+		glLinkProgram(prog->id);
 
-	jglsl_shader_c() : m_program(0) {
-		import_std_builtin_types();
-	}
+		jglsl_program_t* prev = m_prog;
+		m_prog = prog;
+		if (!complete_link()) {
+			release_program();
+			m_prog = prev;
+			refresh_handles();
+			glDeleteShader(shader);
+			return false;
+		}
 
-	~jglsl_shader_c() {
-		unload();
-	}
+		m_prog = prev;
+		release_program();
+		m_prog = prog;
 
-	const char* get_log() const {
-		return m_log_buffer.empty() ? 0 : &m_log_buffer[0];
-	}
-		
-	void register_builtin_type(const std::string& type,const bool complex) {
-		if (!complex)
-			m_builtin_types.push_back(type);
-		else
-			m_complex_builtin_types.push_back(type);
+		kept_stage_t& st = m_stages[s];
+		glDeleteShader(st.shader);
+		st.shader = shader;
+		st.code.assign(code,len);
+		st.defines = defines;
+		st.decl_hash = decl_hash;
+		if (rescan)
+			std::swap(st.reflection,reflection);
+		if (!m_specializations.empty())
+			commit_specializations();
+		return true;
 	}
 
-	void import_std_builtin_types() {
-		m_builtin_types.clear();
-		m_complex_builtin_types.clear();
+	/*
+		Turns a scalar uniform (int,uint,bool,float) set once per session into a constant of value,the driver
+		can then fold the branches on it.Needs the stage sources,so hot reload has to be on (see set_hot_reload()).
+		Takes effect with the next commit_specializations(),setters of the uniform are dropped from then on.
+	*/
+	bool specialize(const std::string& uni,const double value) {
+		std::string type;
+		for (uint32_t i = 0,j = m_stages.size();(i < j) && type.empty();++i) {
+			const scan_result_t& r = m_stages[i].reflection;
+			for (uint32_t k = 0,w = r.uniforms.size();k < w;++k) {
+				if ((r.uniforms[k] == uni) && (r.uniform_counts[k] == 1)) {
+					type = r.uniform_types[k];
+					break;
+				}
+			}
+		}
 
-		register_builtin_type("int",false);
-		register_builtin_type("uint",false);
-		register_builtin_type("bool",false);
-		register_builtin_type("float",false);
-		register_builtin_type("double",false);
-		register_builtin_type("atomic_uint",false);
-		register_builtin_type("vec",true);
-		register_builtin_type("mat",true);
-		register_builtin_type("image",true);
-		register_builtin_type("sampler",true);
-	}
+		//Only declarations of their own can be rewritten
+		std::vector<specialization_t> probe(1);
+		std::vector<uint8_t> applied(1,0);
+		std::string code;
+		probe[0].name = uni;
+		for (uint32_t i = 0,j = m_stages.size();(i < j) && (!type.empty()) && (!applied[0]);++i)
+			specialize_source(m_stages[i].code,probe,code,applied);
+		if (!applied[0])
+			type.clear();
 
-	void unload() {
-		if (m_program != 0) {
-			unbind();
-			glDeleteProgram(m_program);
-			m_program = 0;
+		char literal[64];
+		if (type == "int") {
+			sprintf(literal,"%d",(int32_t)value);
+		} else if (type == "uint") {
+			sprintf(literal,"%uu",(uint32_t)(int64_t)value);
+		} else if (type == "bool") {
+			strcpy(literal,(value != 0.0) ? "true" : "false");
+		} else if ((type == "float") && (value >= -3.4e38) && (value <= 3.4e38)) {
+			sprintf(literal,"%.9g",value);
+			if (!strpbrk(literal,".e"))
+				strcat(literal,".0");
+		} else {
+			append_log("specialize() : Not a scalar uniform declared on its own in a hot reload stage : ");
+			append_log(uni.c_str());
+			append_log("\n");
+			return false;
 		}
 
-		m_pending_attributes.clear();
-		m_pending_uniforms.clear();
-		m_shaders.clear();
-		m_attributes.clear();
-		m_uniforms.clear();
-	}
+		for (uint32_t i = 0,j = m_specializations.size();i < j;++i) {
+			if (m_specializations[i].name == uni) {
+				m_specializations[i].value = literal;
+				return true;
+			}
+		}
 
-	inline void bind() {
-		glUseProgram(m_program);
+		const specialization_t spec = { uni,literal };
+		m_specializations.push_back(spec);
+		return true;
 	}
 
-	inline void unbind() {
-		glUseProgram(0);
+	//Back to a uniform with the next commit_specializations()
+	void unspecialize(const std::string& uni) {
+		for (uint32_t i = 0,j = m_specializations.size();i < j;++i) {
+			if (m_specializations[i].name == uni) {
+				m_specializations.erase(m_specializations.begin() + i);
+				return;
+			}
+		}
 	}
 
-	inline uint32_t get_attribute(const std::string& attr) {
-		std::map<std::string,uint32_t>::iterator it = m_attributes.find(attr);
-		return (it != m_attributes.end()) ? it->second : 0;
-	}
+	/*
+		Compiles and links the stages rewritten with the current specializations through the async path.
+		The current program stays in use until poll() finds the variant linked and swaps it in,uniform values
+		set so far are carried over.A variant still being built is dropped.
+	*/
+	bool commit_specializations() {
+		if (m_stages.empty()) {
+			append_log("commit_specializations() : Stages were not loaded with hot reload on\n");
+			return false;
+		}
+		drop_specialized();
+		JGLSL_PROFILE_PHASE(JGLSL_PHASE_LOAD);
+
+		jglsl_program_t* prog = new jglsl_program_t();
+		prog->refs = 1;
+		prog->key = jglsl_fnv1a64(0,0);
+		prog->stage_bits = m_prog->stage_bits;
+		prog->link_pending = true;
+		prog->id = glCreateProgram();
+		if (m_separable)
+			glProgramParameteri(prog->id,GL_PROGRAM_SEPARABLE,GL_TRUE);
+
+		std::string code;
+		std::vector<uint8_t> applied(m_specializations.size(),0);
+		for (uint32_t i = 0,j = m_stages.size();i < j;++i) {
+			const kept_stage_t& st = m_stages[i];
+			specialize_source(st.code,m_specializations,code,applied);
+
+			const GLuint shader = create_shader(st.type,code.c_str(),code.length(),st.defines);
+			glAttachShader(prog->id,shader);
+			prog->shaders.push_back(shader);
+			prog->unchecked_shaders.push_back(shader);
+			prog->key = stage_hash(st.type,code.c_str(),code.length(),st.defines,prog->key);
+
+			JGLSL_PROFILE_PHASE(JGLSL_PHASE_PARSE);
+			scan_result_t reflection;
+			scan_source(reflection,st.type,code.c_str(),code.length(),st.defines,*m_builtin_types);
+			prog->reflection.append(reflection);
+		}
+		glLinkProgram(prog->id);
 
-	inline uint32_t get_uniform(const std::string& uni)  {
-		std::map<std::string,uint32_t>::iterator it = m_uniforms.find(uni);
-		return (it != m_uniforms.end()) ? it->second : 0;
+		for (uint32_t i = 0,j = m_specializations.size();i < j;++i) {
+			if (applied[i])
+				prog->specialized.push_back(m_specializations[i].name);
+		}
+		m_specialized = prog;
+		return true;
 	}
 
-	inline void add_attribute(const std::string& attr) {
-		m_attributes.insert ( std::pair<std::string,uint32_t>(attr,glGetAttribLocation(m_program,attr.c_str())) );
+	//A specialized variant is being built (poll() swaps it in)
+	inline bool is_specializing() const {
+		return m_specialized != 0;
 	}
 
-	inline void add_uniform(const std::string& uni) {
-		m_uniforms.insert ( std::pair<std::string,uint32_t>(uni,glGetUniformLocation(m_program,uni.c_str())) );
+	bool reload(const GLenum type,const std::string& code,const jglsl_define_set_t& defines = jglsl_define_set_t::none()) {
+		return reload(type,code.c_str(),code.length(),defines);
 	}
 
-	bool load(const GLenum type,const char* code,const uint32_t len) {
-		GLuint tmp = glCreateShader(type);
-		GLint res;
-		const GLint length = (const GLint)len;
-		glShaderSource(tmp,1,&code,&length);
-		glCompileShader(tmp);
-		glGetShaderiv(tmp,GL_COMPILE_STATUS,&res);
+	/*
+		Returns true once the pending link has completed (status available through is_linked()).
+		Never blocks when GL_KHR_parallel_shader_compile is available,otherwise it completes the link in place.
+	*/
+	bool poll() {
+		if (m_specialized)
+			poll_specialized();
 
-		parse_vars(m_pending_uniforms,"uniform",code,len,m_builtin_types,m_complex_builtin_types);
-		parse_vars(m_pending_attributes,"attribute",code,len,m_builtin_types,m_complex_builtin_types);
-		if (res != GL_FALSE) {
-			m_shaders.push_back(tmp);
+		if (!m_prog->link_pending) {
+			refresh_stale_handles();
 			return true;
 		}
- 
-		GLint gl_log_len;		
-		glGetShaderiv(tmp, GL_INFO_LOG_LENGTH,&gl_log_len);
-		GLchar * gl_log = new GLchar[gl_log_len];
-		if (!gl_log)return false;
-		glGetShaderInfoLog(tmp,gl_log_len,NULL,gl_log);
-		
-		m_log_buffer.push_back('L');
-		m_log_buffer.push_back('D');
-		m_log_buffer.push_back(':');
-		for (GLint i = 0;i < gl_log_len;++i)
-			m_log_buffer.push_back(gl_log[i]);
-		m_log_buffer.push_back('\n');
-		delete [] gl_log;
-		return false;
+
+		if (jglsl_gl_caps().parallel_compile) {
+			GLint done = GL_FALSE;
+			glGetProgramiv(m_prog->id,GL_COMPLETION_STATUS_KHR,&done);
+			if (done == GL_FALSE)
+				return false;
+		}
+
+		complete_link();
+		return true;
 	}
 
-	bool load(const GLenum type,const std::string& code) {
-		return load(type,code.c_str(),code.length());
+	inline bool is_ready() const {
+		return !m_prog->link_pending;
 	}
 
-	bool finalize() {
-		bool ret = true;
-		GLint status;
+	inline bool is_linked() const {
+		return (!m_prog->link_pending) && m_prog->link_status;
+	}
 
-		if (m_shaders.empty()) {
-			const char* no_shdr = "finalize() : No GLSL compiled shaders found!\n";	
-			const int32_t len = strlen(no_shdr);
-			for (int32_t i = 0;i < len;++i)
-				m_log_buffer.push_back(no_shdr[i]);
-			
+	bool finalize() {
+		if (!finalize_async())
 			return false;
-		}
 
-		if (m_program != 0) {
-			char tmp[256];
-			int32_t len;
+		return m_prog->link_pending ? complete_link() : m_prog->link_status;
+	}
 
-			sprintf(tmp,"finalize() : Warning previous program(%u) is still active.\nShutting it down..\n",m_program);
-			len = strlen(tmp);
+	/*
+		finalize() of many programs,in two passes : first every deferred compile (load_async()/prepare())
+		and glLinkProgram is issued,then status,logs and locations are collected.The driver links
+		in the meantime instead of being waited on after each program.With GL_KHR_parallel_shader_compile
+		programs already done are collected first.Returns true if all of them linked.
+	*/
+	static bool finalize_all(const std::vector<jglsl_shader_c*>& shaders,jglsl_finalize_stats_t* stats = 0) {
+		typedef std::chrono::steady_clock steady_t;
+		const steady_t::time_point start = steady_t::now();
+		std::vector<uint8_t> issued(shaders.size(),0);
+		for (uint32_t i = 0,j = shaders.size();i < j;++i)
+			issued[i] = shaders[i]->finalize_async() ? 1 : 0;
+		const steady_t::time_point submitted = steady_t::now();
 
-			for (int32_t i = 0;i < len;++i)
-				m_log_buffer.push_back(tmp[i]);
+		if (jglsl_gl_caps().parallel_compile) {
+			for (uint32_t i = 0,j = shaders.size();i < j;++i) {
+				jglsl_program_t* prog = shaders[i]->m_prog;
+				if ((!issued[i]) || (!prog->link_pending))
+					continue;
 
-			unbind();
-			glDeleteProgram(m_program);
+				GLint done = GL_FALSE;
+				glGetProgramiv(prog->id,GL_COMPLETION_STATUS_KHR,&done);
+				if (done != GL_FALSE)
+					shaders[i]->complete_link();
+			}
 		}
 
-		m_program = glCreateProgram();
-		for (uint32_t i = 0,j = m_shaders.size();i < j;++i)
-			glAttachShader(m_program,m_shaders[i]);
+		uint32_t linked = 0;
+		for (uint32_t i = 0,j = shaders.size();i < j;++i) {
+			if (!issued[i])
+				continue;
+			if (shaders[i]->m_prog->link_pending)
+				shaders[i]->complete_link();
+			shaders[i]->refresh_stale_handles();	//Shared programs are linked by the first instance only
+			if (shaders[i]->m_prog->link_status)
+				++linked;
+		}
 
-		glLinkProgram(m_program);
-		glGetProgramiv(m_program, GL_LINK_STATUS, &status);
-		if (status == GL_FALSE) {
-			GLint gl_log_len;
-		
-			glGetProgramiv(m_program, GL_INFO_LOG_LENGTH, &gl_log_len);
-			GLchar* gl_log = new GLchar[gl_log_len];
-			if (!gl_log) return false;
-			glGetProgramInfoLog(m_program, gl_log_len, NULL, gl_log);
-
-			m_log_buffer.push_back('L');
-			m_log_buffer.push_back('N');
-			m_log_buffer.push_back('K');
-			m_log_buffer.push_back(':');
-			for (GLint i = 0;i < gl_log_len;++i)
-				m_log_buffer.push_back(gl_log[i]);
-			m_log_buffer.push_back('\n');
-			delete [] gl_log;
-			ret = false;
+		if (stats) {
+			stats->programs = shaders.size();
+			stats->linked = linked;
+			stats->failed = stats->programs - linked;
+			stats->submit_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(submitted - start).count();
+			stats->collect_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(steady_t::now() - submitted).count();
 		}
+		return linked == shaders.size();
+	}
 
-		for (uint32_t i = 0,j = m_shaders.size();i < j;++i)
-			glDeleteShader(m_shaders[i]);
+#ifndef JGLSL_NO_GLUNIFORM_MACROS
+	//By name (literals are hashed at compile time,see jglsl_uniform_key_t)
+	template <typename scalar_t>
+	inline void u_f(const jglsl_uniform_key_t& name,const scalar_t f) {
+		u_f(get_uniform(name),f);
+	}
+
+	template <typename scalar_t>
+	inline void u_2fv(const jglsl_uniform_key_t& name,const scalar_t* f)  {
+		u_2fv(get_uniform(name),f);
+	}
 
-		m_attributes.clear();
-		m_uniforms.clear();
+	template <typename scalar_t>
+	inline void u_3fv(const jglsl_uniform_key_t& name,const scalar_t* f) {
+		u_3fv(get_uniform(name),f);
+	}
 
-		for (uint32_t i = 0,j = m_pending_attributes.size();i < j;++i)
-			add_attribute(m_pending_attributes[i]);
+	template <typename scalar_t>
+	inline void u_4fv(const jglsl_uniform_key_t& name,const scalar_t* f)  {
+		u_4fv(get_uniform(name),f);
+	}
 
-		for (uint32_t i = 0,j = m_pending_uniforms.size();i < j;++i)
-			add_uniform(m_pending_uniforms[i]);
+	template <typename scalar_t>
+	inline void u_mat3_fv(const jglsl_uniform_key_t& name,const scalar_t* m)  {
+		u_mat3_fv(get_uniform(name),m);
+	}
 
-		m_pending_attributes.clear();
-		m_pending_uniforms.clear();
-		m_shaders.clear();
+	template <typename scalar_t>
+	inline void u_mat4_fv(const jglsl_uniform_key_t& name,const scalar_t* m) {
+		u_mat4_fv(get_uniform(name),m);
+	}
 
-		if (ret) 
-			m_log_buffer.clear();
-	
-		return ret;
+	inline void u_u32(const jglsl_uniform_key_t& name,const uint32_t ui)  {
+		u_u32(get_uniform(name),ui);
 	}
 
-#ifndef JGLSL_NO_GLUNIFORM_MACROS
-	//By name
+	//Arrays,cnt elements from the named one in a single call ("bones" or "bones[4]")
 	template <typename scalar_t>
-	inline void u_f(const std::string& name,const scalar_t f) {
-		if (sizeof(scalar_t) == 4)
-			glUniform1f(get_uniform(name),f);
-		else
-			glUniform1d(get_uniform(name),f);
+	inline void u_fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* f) {
+		u_fv(get_uniform(name),cnt,f);
 	}
 
 	template <typename scalar_t>
-	inline void u_2fv(const std::string& name,const scalar_t* f)  {
-		if (sizeof(scalar_t) == 4)
-			glUniform2fv(get_uniform(name),1,f);
-		else
-			glUniform2dv(get_uniform(name),1,f);
+	inline void u_2fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* f) {
+		u_2fv(get_uniform(name),cnt,f);
 	}
 
 	template <typename scalar_t>
-	inline void u_3fv(const std::string& name,const scalar_t* f) {
-		if (sizeof(scalar_t) == 4)
-			glUniform3fv(get_uniform(name),1,f);
-		else
-			glUniform3dv(get_uniform(name),1,f);
+	inline void u_3fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* f) {
+		u_3fv(get_uniform(name),cnt,f);
 	}
 
 	template <typename scalar_t>
-	inline void u_4fv(const std::string& name,const scalar_t* f)  {
-		if (sizeof(scalar_t) == 4)
-    		glUniform4fv(get_uniform(name),1,f);
-		else
-    		glUniform4dv(get_uniform(name),1,f);
+	inline void u_4fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* f) {
+		u_4fv(get_uniform(name),cnt,f);
 	}
 
 	template <typename scalar_t>
-	inline void u_mat3_fv(const std::string& name,const scalar_t* m)  {
-		if (sizeof(scalar_t) == 4)
-    		glUniformMatrix3fv(get_uniform(name),1,GL_FALSE,m);
-		else
-    		glUniformMatrix3dv(get_uniform(name),1,GL_FALSE,m);
+	inline void u_mat3_fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* m) {
+		u_mat3_fv(get_uniform(name),cnt,m);
 	}
 
 	template <typename scalar_t>
-	inline void u_mat4_fv(const std::string& name,const scalar_t* m) {
-		if (sizeof(scalar_t) == 4)
-    		glUniformMatrix4fv(get_uniform(name),1,GL_FALSE,m);
-		else
-    		glUniformMatrix4dv(get_uniform(name),1,GL_FALSE,m);
+	inline void u_mat4_fv(const jglsl_uniform_key_t& name,const uint32_t cnt,const scalar_t* m) {
+		u_mat4_fv(get_uniform(name),cnt,m);
+	}
+
+	inline void u_s32v(const jglsl_uniform_key_t& name,const uint32_t cnt,const int32_t* i) {
+		u_s32v(get_uniform(name),cnt,i);
 	}
 
-	inline void u_u32(const std::string& name,const uint32_t ui)  {
-    	glUniform1ui(get_uniform(name),ui);
+	inline void u_u32v(const jglsl_uniform_key_t& name,const uint32_t cnt,const uint32_t* ui) {
+		u_u32v(get_uniform(name),cnt,ui);
 	}
 
-	inline void u_u32v(const std::string& name,const uint32_t cnt,const uint32_t* ui) {
-    	glUniform1uiv(get_uniform(name),cnt,ui);
+	inline void u_s32(const jglsl_uniform_key_t& name,const int32_t i) {
+		u_s32(get_uniform(name),i);
 	}
 
-	inline void u_s32(const std::string& name,const int32_t i) {
-    	glUniform1i(get_uniform(name),i);
+	inline void u_tex(const jglsl_uniform_key_t& name,const int32_t id) {
+		u_tex(get_uniform(name),id);
 	}
 
-	inline void u_tex(const std::string& name,const int32_t id) {
-		glUniform1i(get_uniform(name),id);
+#ifdef GL_ARB_bindless_texture
+	inline void u_tex_handle(const jglsl_uniform_key_t& name,const GLuint64 handle) {
+		u_tex_handle(get_uniform(name),handle);
 	}
+#endif
 
 	//By index (cached results by get_uniform())
 	template <typename scalar_t>
 	inline void u_f(const uint32_t name,const scalar_t f) const {
-		if (sizeof(scalar_t) == 4)
-			glUniform1f(name,f);
-		else
-			glUniform1d(name,f);
+		if (sizeof(scalar_t) == 4) {
+			const GLfloat v = (GLfloat)f;
+			set_uniform(JGLSL_UK_1F,name,1,&v);
+		} else {
+			const GLdouble v = (GLdouble)f;
+			set_uniform(JGLSL_UK_1D,name,1,&v);
+		}
 	}
 
 	template <typename scalar_t>
 	inline void u_2fv(const uint32_t name,const scalar_t* f) const {
-		if (sizeof(scalar_t) == 4)
-			glUniform2fv(name,1,f);
-		else
-			glUniform2dv(name,1,f);
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_2F : JGLSL_UK_2D,name,1,f);
 	}
 
 	template <typename scalar_t>
 	inline void u_3fv(const uint32_t name,const scalar_t* f) const {
-		if (sizeof(scalar_t) == 4)
-			glUniform3fv(name,1,f);
-		else
-			glUniform3dv(name,1,f);
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_3F : JGLSL_UK_3D,name,1,f);
 	}
 
 	template <typename scalar_t>
 	inline void u_4fv(const uint32_t name,const scalar_t* f) const {
-		if (sizeof(scalar_t) == 4)
-    		glUniform4fv(name,1,f);
-		else
-    		glUniform4dv(name,1,f);
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_4F : JGLSL_UK_4D,name,1,f);
 	}
 
 	template <typename scalar_t>
 	inline void u_mat3_fv(const uint32_t name,const scalar_t* m) const {
-		if (sizeof(scalar_t) == 4)
-    		glUniformMatrix3fv(name,1,GL_FALSE,m);
-		else
-    		glUniformMatrix3dv(name,1,GL_FALSE,m);
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_MAT3F : JGLSL_UK_MAT3D,name,1,m);
 	}
 
 	template <typename scalar_t>
 	inline void u_mat4_fv(const uint32_t name,const scalar_t* m) const {
-		if (sizeof(scalar_t) == 4)
-    		glUniformMatrix4fv(name,1,GL_FALSE,m);
-		else
-    		glUniformMatrix4dv(name,1,GL_FALSE,m);
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_MAT4F : JGLSL_UK_MAT4D,name,1,m);
 	}
 
 	inline void u_u32(const uint32_t name,const uint32_t ui) const {
-    	glUniform1ui(name,ui);
+		set_uniform(JGLSL_UK_1UI,name,1,&ui);
+	}
+
+	template <typename scalar_t>
+	inline void u_fv(const uint32_t name,const uint32_t cnt,const scalar_t* f) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_1F : JGLSL_UK_1D,name,cnt,f);
+	}
+
+	template <typename scalar_t>
+	inline void u_2fv(const uint32_t name,const uint32_t cnt,const scalar_t* f) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_2F : JGLSL_UK_2D,name,cnt,f);
+	}
+
+	template <typename scalar_t>
+	inline void u_3fv(const uint32_t name,const uint32_t cnt,const scalar_t* f) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_3F : JGLSL_UK_3D,name,cnt,f);
+	}
+
+	template <typename scalar_t>
+	inline void u_4fv(const uint32_t name,const uint32_t cnt,const scalar_t* f) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_4F : JGLSL_UK_4D,name,cnt,f);
+	}
+
+	template <typename scalar_t>
+	inline void u_mat3_fv(const uint32_t name,const uint32_t cnt,const scalar_t* m) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_MAT3F : JGLSL_UK_MAT3D,name,cnt,m);
+	}
+
+	template <typename scalar_t>
+	inline void u_mat4_fv(const uint32_t name,const uint32_t cnt,const scalar_t* m) const {
+		set_uniform((sizeof(scalar_t) == 4) ? JGLSL_UK_MAT4F : JGLSL_UK_MAT4D,name,cnt,m);
+	}
+
+	inline void u_s32v(const uint32_t name,const uint32_t cnt,const int32_t* i) const {
+		set_uniform(JGLSL_UK_1I,name,cnt,i);
 	}
 
 	inline void u_u32v(const uint32_t name,const uint32_t cnt,const uint32_t* ui) const {
-    	glUniform1uiv(name,cnt,ui);
+		set_uniform(JGLSL_UK_1UI,name,cnt,ui);
 	}
 
 	inline void u_s32(const uint32_t name,const int32_t i) const {
-    	glUniform1i(name,i);
+		set_uniform(JGLSL_UK_1I,name,1,&i);
 	}
 
 	inline void u_tex(const uint32_t name,const int32_t id) const {
-		glUniform1i(name,id);
+		set_uniform(JGLSL_UK_1I,name,1,&id);
+	}
+
+#ifdef GL_ARB_bindless_texture
+	//ARB_bindless_texture (jglsl_gl_caps().bindless_texture) : a resident handle instead of a unit,see jglsl_resident_texture_handle()
+	inline void u_tex_handle(const uint32_t name,const GLuint64 handle) const {
+		set_uniform(JGLSL_UK_HANDLE,name,1,&handle);
+	}
+#endif
+
+	//Shadow state statistics (calls forwarded to GL / calls dropped because the value did not change)
+	inline uint32_t get_uniform_calls_issued() const {
+		return m_uniform_calls_issued;
+	}
+
+	inline uint32_t get_uniform_calls_skipped() const {
+		return m_uniform_calls_skipped;
+	}
+
+	inline void reset_uniform_call_counters() {
+		m_uniform_calls_issued = 0;
+		m_uniform_calls_skipped = 0;
+#ifdef JGLSL_PROFILE
+		m_frame_calls_mark = 0;
+#endif
+	}
+
+	//Call this if uniforms of this program were modified behind the wrapper's back (staged values are still sent)
+	void invalidate_uniform_cache() {
+		for (uint32_t i = 0,j = m_prog->uniform_states.size();i < j;++i)
+			m_prog->uniform_states[i].bytes = 0;
 	}
 #endif
 };
 
+/*
+	Once per frame,after the last draw : closes the open GPU span and moves the per frame counters
+	and GPU times of every instance into its get_stats().
+*/
+inline void jglsl_profile_end_frame() {
+	jglsl_profile_state_t& state = jglsl_profile_state();
+	jglsl_end_gpu_span();
+#ifdef JGLSL_PROFILE
+	for (uint32_t i = 0,j = state.instances.size();i < j;++i)
+		state.instances[i]->end_profile_frame(state.frame);
+#endif
+	++state.frame;
+}
+
 #endif
 
@@ -0,0 +1,399 @@
+/*
+	Memory mapped shader pack for jglsl_shader_c.
+	One indexed file holds every program (stage list,sources and optional precomputed reflection),
+	it is opened and mapped once and stage sources are handed to jglsl_shader_c::load() in place.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_shader_pack_c_
+#define _jglsl_shader_pack_c_
+
+#include "jglsl_shader.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+	Layout (all integers are little endian uint32) :
+
+	header			magic "JGSK",version,program_count,reserved
+	program table	program_count x { name_offset,name_len,stage_first,stage_count,reflection_offset,reflection_len }
+					sorted by name
+	stage table		{ type,source_offset,source_len } referenced by stage_first/stage_count
+	blobs			names,sources and reflection (jglsl_shader_c::reflect_sources() output),offsets are from file start
+
+	Example usage :
+
+	jglsl_shader_pack_c pack;
+	pack.open("shaders.jgsk");
+
+	jglsl_shader_c* shader = new jglsl_shader_c();
+	pack.load("test",*shader);	//No copies,the pack must stay open until finalize()
+	shader->finalize();
+*/
+
+static const uint32_t jglsl_pack_magic = 0x4B53474Au;	//"JGSK"
+static const uint32_t jglsl_pack_version = 1;
+static const uint32_t jglsl_pack_header_size = 16;
+static const uint32_t jglsl_pack_program_size = 24;
+static const uint32_t jglsl_pack_stage_size = 12;
+
+class jglsl_shader_pack_c {
+	private:
+	const uint8_t* m_data;
+	uint32_t m_size;
+	uint32_t m_program_count;
+	uint32_t m_stage_count;
+	const uint8_t* m_programs;
+	const uint8_t* m_stages;
+#ifdef _WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#endif
+
+	static inline uint32_t rd32(const uint8_t* p) {
+		return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+	}
+
+	inline const uint8_t* program(const uint32_t i) const {
+		return m_programs + i * jglsl_pack_program_size;
+	}
+
+	inline const uint8_t* stage(const uint32_t prog,const uint32_t s) const {
+		return m_stages + (rd32(program(prog) + 8) + s) * jglsl_pack_stage_size;
+	}
+
+	inline bool in_range(const uint32_t offs,const uint32_t len) const {
+		return (offs <= m_size) && (len <= (m_size - offs));
+	}
+
+	//Every offset is checked once here so accessors can trust the index
+	bool validate() {
+		if ((m_size < jglsl_pack_header_size) || (rd32(m_data) != jglsl_pack_magic) || (rd32(m_data + 4) != jglsl_pack_version))
+			return false;
+
+		m_program_count = rd32(m_data + 8);
+		if ((m_program_count > (m_size / jglsl_pack_program_size)) ||
+			(!in_range(jglsl_pack_header_size,m_program_count * jglsl_pack_program_size)))
+			return false;
+
+		m_programs = m_data + jglsl_pack_header_size;
+		const uint32_t stage_offs = jglsl_pack_header_size + m_program_count * jglsl_pack_program_size;
+		m_stages = m_data + stage_offs;
+		m_stage_count = (m_size - stage_offs) / jglsl_pack_stage_size;
+
+		uint32_t stage_end = 0;
+		for (uint32_t i = 0;i < m_program_count;++i) {
+			const uint8_t* p = program(i);
+			const uint32_t first = rd32(p + 8),count = rd32(p + 12);
+
+			if ((!in_range(rd32(p),rd32(p + 4))) || (!in_range(rd32(p + 16),rd32(p + 20))))
+				return false;
+			if ((first > m_stage_count) || (count > (m_stage_count - first)))
+				return false;
+			if ((first + count) > stage_end)
+				stage_end = first + count;
+		}
+
+		m_stage_count = stage_end;
+		for (uint32_t i = 0;i < m_stage_count;++i) {
+			const uint8_t* st = m_stages + i * jglsl_pack_stage_size;
+			if (!in_range(rd32(st + 4),rd32(st + 8)))
+				return false;
+		}
+
+		return true;
+	}
+
+	public:
+	jglsl_shader_pack_c() : m_data(0),m_size(0),m_program_count(0),m_stage_count(0),m_programs(0),m_stages(0) {
+#ifdef _WIN32
+		m_file = INVALID_HANDLE_VALUE;
+		m_mapping = 0;
+#endif
+	}
+
+	~jglsl_shader_pack_c() {
+		close();
+	}
+
+	//One open + one mapping for the whole pack
+	bool open(const char* path) {
+		close();
+
+#ifdef _WIN32
+		m_file = CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,0,OPEN_EXISTING,FILE_FLAG_RANDOM_ACCESS,0);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		if ((!GetFileSizeEx(m_file,&size)) || (size.QuadPart <= 0) || (size.QuadPart > 0xFFFFFFFFll)) {
+			close();
+			return false;
+		}
+
+		m_mapping = CreateFileMappingA(m_file,0,PAGE_READONLY,0,0,0);
+		if (m_mapping)
+			m_data = (const uint8_t*)MapViewOfFile(m_mapping,FILE_MAP_READ,0,0,0);
+		m_size = (uint32_t)size.QuadPart;
+#else
+		const int fd = ::open(path,O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st;
+		if ((fstat(fd,&st) != 0) || (st.st_size <= 0) || ((uint64_t)st.st_size > 0xFFFFFFFFull)) {
+			::close(fd);
+			return false;
+		}
+
+		void* data = mmap(0,st.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+		::close(fd);	//The mapping keeps the file referenced
+		if (data != MAP_FAILED) {
+			m_data = (const uint8_t*)data;
+			m_size = (uint32_t)st.st_size;
+		}
+#endif
+
+		if ((!m_data) || (!validate())) {
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void close() {
+#ifdef _WIN32
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mapping)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_mapping = 0;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_data)
+			munmap((void*)m_data,m_size);
+#endif
+		m_data = 0;
+		m_size = 0;
+		m_program_count = 0;
+		m_stage_count = 0;
+		m_programs = 0;
+		m_stages = 0;
+	}
+
+	inline bool is_open() const {
+		return m_data != 0;
+	}
+
+	inline uint32_t get_program_count() const {
+		return m_program_count;
+	}
+
+	inline jglsl_span_t get_name(const uint32_t prog) const {
+		const jglsl_span_t s = { (const char*)m_data + rd32(program(prog)),rd32(program(prog) + 4) };
+		return s;
+	}
+
+	//Binary search over the sorted program table,-1 if not found
+	int32_t find(const char* name) const {
+		const uint32_t len = strlen(name);
+		int32_t lo = 0,hi = (int32_t)m_program_count - 1;
+
+		while (lo <= hi) {
+			const int32_t mid = (lo + hi) >> 1;
+			const jglsl_span_t n = get_name(mid);
+			int32_t c = memcmp(n.ptr,name,(n.len < len) ? n.len : len);
+			if (c == 0)
+				c = (n.len < len) ? -1 : (n.len > len);
+
+			if (c == 0)
+				return mid;
+			else if (c < 0)
+				lo = mid + 1;
+			else
+				hi = mid - 1;
+		}
+
+		return -1;
+	}
+
+	inline uint32_t get_stage_count(const uint32_t prog) const {
+		return rd32(program(prog) + 12);
+	}
+
+	inline GLenum get_stage_type(const uint32_t prog,const uint32_t s) const {
+		return (GLenum)rd32(stage(prog,s));
+	}
+
+	inline jglsl_span_t get_stage_source(const uint32_t prog,const uint32_t s) const {
+		const jglsl_span_t src = { (const char*)m_data + rd32(stage(prog,s) + 4),rd32(stage(prog,s) + 8) };
+		return src;
+	}
+
+	//Empty span when the program was packed without reflection
+	inline jglsl_span_t get_reflection(const uint32_t prog) const {
+		const jglsl_span_t r = { (const char*)m_data + rd32(program(prog) + 16),rd32(program(prog) + 20) };
+		return r;
+	}
+
+	/*
+		Feeds every stage of the program to shader.load() (or load_async()) straight from the mapping.
+		Precomputed reflection,when present,replaces parsing (false if it is damaged,nothing loaded).
+		The pack must stay open until finalize().
+	*/
+	bool load(const uint32_t prog,jglsl_shader_c& shader,const bool async = false) const {
+		if (prog >= m_program_count)
+			return false;
+
+		const jglsl_span_t refl = get_reflection(prog);
+		if ((refl.len != 0) && (!shader.set_precomputed_reflection((const uint8_t*)refl.ptr,refl.len)))
+			return false;
+
+		//Only the pack's sources are referenced,later load() calls of the caller copy theirs again
+		const bool persistent = shader.is_persistent_sources();
+		shader.set_persistent_sources(true);
+
+		bool ret = true;
+		for (uint32_t s = 0,j = get_stage_count(prog);s < j;++s) {
+			if (async)
+				ret &= shader.load_async(get_stage_type(prog,s),get_stage_source(prog,s));
+			else
+				ret &= shader.load(get_stage_type(prog,s),get_stage_source(prog,s));
+		}
+
+		shader.set_persistent_sources(persistent);
+		return ret;
+	}
+
+	bool load(const char* name,jglsl_shader_c& shader,const bool async = false) const {
+		const int32_t prog = find(name);
+		return (prog >= 0) && load((uint32_t)prog,shader,async);
+	}
+};
+
+//Offline side : collects programs and writes a pack readable by jglsl_shader_pack_c
+class jglsl_shader_pack_writer_c {
+	private:
+	struct stage_t {
+		GLenum type;
+		std::string code;
+	};
+
+	struct program_t {
+		std::string name;
+		std::vector<stage_t> stages;
+		std::vector<uint8_t> reflection;
+
+		inline bool operator<(const program_t& p) const {
+			return name < p.name;
+		}
+	};
+
+	std::vector<program_t> m_programs;
+
+	static void put_u32(std::vector<uint8_t>& out,const uint32_t v) {
+		const uint8_t b[4] = { (uint8_t)v,(uint8_t)(v >> 8),(uint8_t)(v >> 16),(uint8_t)(v >> 24) };
+		out.insert(out.end(),b,b + 4);
+	}
+
+	static void set_u32(std::vector<uint8_t>& out,const uint32_t offs,const uint32_t v) {
+		out[offs] = (uint8_t)v;
+		out[offs + 1] = (uint8_t)(v >> 8);
+		out[offs + 2] = (uint8_t)(v >> 16);
+		out[offs + 3] = (uint8_t)(v >> 24);
+	}
+
+	static void put_blob(std::vector<uint8_t>& out,const uint32_t entry,const void* data,const uint32_t len) {
+		set_u32(out,entry,out.size());
+		set_u32(out,entry + 4,len);
+		out.insert(out.end(),(const uint8_t*)data,(const uint8_t*)data + len);
+	}
+
+	public:
+	void add_program(const std::string& name) {
+		m_programs.push_back(program_t());
+		m_programs.back().name = name;
+	}
+
+	//Appends a stage to the last added program
+	void add_stage(const GLenum type,const char* code,const uint32_t len) {
+		stage_t st;
+		st.type = type;
+		st.code.assign(code,len);
+		m_programs.back().stages.push_back(st);
+	}
+
+	//Stores precomputed reflection for the last added program (parsed with the given shader's builtin types)
+	void reflect(const jglsl_shader_c& shader) {
+		program_t& p = m_programs.back();
+		std::vector<const char*> codes;
+		std::vector<uint32_t> lens;
+		std::vector<GLenum> types;
+
+		for (uint32_t i = 0,j = p.stages.size();i < j;++i) {
+			codes.push_back(p.stages[i].code.c_str());
+			lens.push_back(p.stages[i].code.length());
+			types.push_back(p.stages[i].type);
+		}
+
+		p.reflection.clear();
+		if (!codes.empty())
+			shader.reflect_sources(&codes[0],&lens[0],codes.size(),p.reflection,&types[0]);
+	}
+
+	bool write(const char* path) {
+		std::vector<uint8_t> out;
+		uint32_t stage_count = 0;
+
+		std::sort(m_programs.begin(),m_programs.end());
+		for (uint32_t i = 0,j = m_programs.size();i < j;++i)
+			stage_count += m_programs[i].stages.size();
+
+		put_u32(out,jglsl_pack_magic);
+		put_u32(out,jglsl_pack_version);
+		put_u32(out,m_programs.size());
+		put_u32(out,0);
+
+		const uint32_t prog_offs = out.size();
+		const uint32_t stage_offs = prog_offs + m_programs.size() * jglsl_pack_program_size;
+		out.resize(stage_offs + stage_count * jglsl_pack_stage_size,0);
+
+		for (uint32_t i = 0,s = 0,j = m_programs.size();i < j;++i) {
+			const program_t& p = m_programs[i];
+			const uint32_t entry = prog_offs + i * jglsl_pack_program_size;
+
+			put_blob(out,entry,p.name.c_str(),p.name.length());
+			set_u32(out,entry + 8,s);
+			set_u32(out,entry + 12,p.stages.size());
+			put_blob(out,entry + 16,p.reflection.empty() ? 0 : &p.reflection[0],p.reflection.size());
+
+			for (uint32_t k = 0,w = p.stages.size();k < w;++k,++s) {
+				const uint32_t st = stage_offs + s * jglsl_pack_stage_size;
+				set_u32(out,st,p.stages[k].type);
+				put_blob(out,st + 4,p.stages[k].code.c_str(),p.stages[k].code.length());
+			}
+		}
+
+		FILE* f = fopen(path,"wb");
+		if (!f)
+			return false;
+
+		const bool ok = fwrite(&out[0],1,out.size(),f) == out.size();
+		fclose(f);
+		return ok;
+	}
+};
+
+#endif
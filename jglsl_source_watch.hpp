@@ -0,0 +1,142 @@
+/*
+	File watcher driving jglsl_shader_c::reload() for live shader editing.
+	poll() compares the modification time of every watched source file and hands changed files
+	to reload(),only the changed stage is recompiled and the program relinked.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_source_watch_c_
+#define _jglsl_source_watch_c_
+
+#include "jglsl_shader.hpp"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+	Example usage :
+
+	jglsl_shader_c* shader = new jglsl_shader_c();
+	shader->set_hot_reload(true);	//Before the first load()
+	shader->load(GL_VERTEX_SHADER,read_file("test.vert"));
+	shader->load(GL_FRAGMENT_SHADER,read_file("test.frag"));
+	shader->finalize();
+	const jglsl_uniform_handle_t mvp = shader->get_uniform_handle("u_mvp");
+
+	jglsl_source_watch_c watch;
+	watch.add(*shader,GL_VERTEX_SHADER,"test.vert");
+	watch.add(*shader,GL_FRAGMENT_SHADER,"test.frag");
+
+	Separable stages used by a jglsl_pipeline_cache_c : let the watch free the pipelines of replaced programs
+	watch.set_reload_hook(jglsl_pipeline_cache_c::reload_hook,&pipelines);
+
+	Once per frame (or on a timer) :
+		watch.poll();
+		shader->bind();
+		shader->u_mat4_fv(shader->get_uniform(mvp),matrix);
+*/
+
+//Called by poll() when a reload() replaced the program of shader,old_serial : get_program_serial() before it
+typedef void (*jglsl_reload_hook_t)(void* user,jglsl_shader_c& shader,const uint64_t old_serial);
+
+class jglsl_source_watch_c {
+	private:
+	struct watched_t {
+		jglsl_shader_c* shader;
+		GLenum type;
+		std::string path;
+		jglsl_define_set_t defines;
+		time_t mtime;
+	};
+	std::vector<watched_t> m_files;
+	uint32_t m_failures;
+	jglsl_reload_hook_t m_hook;
+	void* m_hook_user;
+
+	static time_t get_mtime(const std::string& path) {
+		struct stat st;
+		return (stat(path.c_str(),&st) == 0) ? st.st_mtime : 0;
+	}
+
+	static bool read_file(const std::string& path,std::string& out) {
+		FILE* f = fopen(path.c_str(),"rb");
+		if (!f)
+			return false;
+
+		char buf[4096];
+		size_t n;
+		out.clear();
+		while ((n = fread(buf,1,sizeof(buf),f)) != 0)
+			out.append(buf,n);
+		fclose(f);
+		return true;
+	}
+
+	public:
+	jglsl_source_watch_c() : m_failures(0),m_hook(0),m_hook_user(0) {}
+
+	//hook(user,...) runs after every reload() that replaced a program (0 : none)
+	void set_reload_hook(const jglsl_reload_hook_t hook,void* user) {
+		m_hook = hook;
+		m_hook_user = user;
+	}
+
+	//defines : the define set the stage was loaded with
+	void add(jglsl_shader_c& shader,const GLenum type,const std::string& path,
+			const jglsl_define_set_t& defines = jglsl_define_set_t::none()) {
+		watched_t w;
+		w.shader = &shader;
+		w.type = type;
+		w.path = path;
+		w.defines = defines;
+		w.mtime = get_mtime(path);
+		m_files.push_back(w);
+	}
+
+	//Stops watching every file of shader (call it before deleting the shader)
+	void remove(const jglsl_shader_c& shader) {
+		for (uint32_t i = 0;i < m_files.size();++i) {
+			if (m_files[i].shader == &shader)
+				m_files.erase(m_files.begin() + i--);
+		}
+	}
+
+	/*
+		Reloads the stages whose file changed since the last poll(),returns how many were reloaded.
+		Failed reloads (see the shader's get_log()) are retried on the next change of the file.
+	*/
+	uint32_t poll() {
+		std::string code;
+		uint32_t reloaded = 0;
+
+		for (uint32_t i = 0,j = m_files.size();i < j;++i) {
+			watched_t& w = m_files[i];
+			const time_t mtime = get_mtime(w.path);
+			if ((mtime == 0) || (mtime == w.mtime))
+				continue;
+
+			w.mtime = mtime;
+			const uint64_t serial = w.shader->get_program_serial();
+			if (read_file(w.path,code) && w.shader->reload(w.type,code,w.defines))
+				++reloaded;
+			else
+				++m_failures;
+
+			if (m_hook && (w.shader->get_program_serial() != serial))
+				m_hook(m_hook_user,*w.shader,serial);
+		}
+		return reloaded;
+	}
+
+	inline uint32_t get_failures() const {
+		return m_failures;
+	}
+
+	inline uint32_t get_file_count() const {
+		return m_files.size();
+	}
+};
+
+#endif
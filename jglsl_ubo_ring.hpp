@@ -0,0 +1,225 @@
+/*
+	Ring buffer for per-draw uniform block data (jglsl_shader_c reflects the member offsets).
+	With GL 4.4 / ARB_buffer_storage the buffer is persistently mapped and alloc() points straight
+	into it,so uploading a draw's block is a memcpy followed by glBindBufferRange.
+	The ring is split in one region per frame in flight,each guarded by a fence,so the CPU never
+	overwrites data the GPU may still read.
+	Without buffer storage writes go to a CPU copy that bind() uploads with glBufferSubData.
+
+	Author  : Dimitris Vlachos (DimitrisV22@gmail.com @https://github.com/DimitrisVlachos)
+	Licence : MIT
+*/
+
+#ifndef _jglsl_ubo_ring_c_
+#define _jglsl_ubo_ring_c_
+
+#include "jglsl_shader.hpp"
+
+#ifndef GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+/*
+	Example usage :
+
+	jglsl_ubo_ring_c ring;
+	ring.create(1 << 20);			//1MB per frame,3 frames in flight
+
+	shader->bind_block("Object",0);	//Binding point 0
+	const jglsl_block_member_t* model = shader->find_block("Object")->find_member("u_model");
+
+	For every draw :
+		uint32_t offs;
+		uint8_t* dst = ring.alloc(shader->find_block("Object")->size,offs);
+		memcpy(dst + model->offset,matrix,64);
+		ring.bind(0,offs,shader->find_block("Object")->size);
+		glDrawElements(...);
+
+	Or when the data is already laid out : ring.push(0,&object,sizeof(object));
+
+	ring.end_frame();	//Once per frame,after the last draw using the ring
+*/
+class jglsl_ubo_ring_c {
+	private:
+	GLuint m_buffer;
+	GLenum m_target;
+	uint8_t* m_mapped;				//Persistent mapping (or m_staging)
+	std::vector<uint8_t> m_staging;
+	std::vector<GLsync> m_fences;	//One per frame region
+	uint32_t m_frame_size;
+	uint32_t m_frame;
+	uint32_t m_head;				//Next free byte (absolute offset into the buffer)
+	uint32_t m_align;
+	uint32_t m_stalls;
+	bool m_persistent;
+
+	static inline uint32_t round_up(const uint32_t v,const uint32_t a) {
+		return ((v + a - 1) / a) * a;
+	}
+
+	public:
+	jglsl_ubo_ring_c() : m_buffer(0),m_target(GL_UNIFORM_BUFFER),m_mapped(0),m_frame_size(0),m_frame(0),m_head(0),
+		m_align(1),m_stalls(0),m_persistent(false) {
+	}
+
+	~jglsl_ubo_ring_c() {
+		destroy();
+	}
+
+	//target : GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER
+	bool create(const uint32_t frame_size,const uint32_t frames = 3,const GLenum target = GL_UNIFORM_BUFFER) {
+		destroy();
+		if ((frame_size == 0) || (frames == 0))
+			return false;
+
+		GLint align = 0;
+		glGetIntegerv((target == GL_UNIFORM_BUFFER) ? GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT : GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT,&align);
+		m_align = (align > 0) ? align : 256;
+		m_target = target;
+		m_frame_size = round_up(frame_size,m_align);
+		m_fences.assign(frames,(GLsync)0);
+
+		const GLsizeiptr total = (GLsizeiptr)m_frame_size * frames;
+		glGenBuffers(1,&m_buffer);
+		glBindBuffer(target,m_buffer);
+
+#ifdef GL_MAP_PERSISTENT_BIT
+		if (jglsl_gl_caps().buffer_storage) {
+			const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(target,total,0,flags);
+			m_mapped = (uint8_t*)glMapBufferRange(target,0,total,flags);
+			m_persistent = m_mapped != 0;
+		}
+#endif
+
+		if (!m_persistent) {
+			glBufferData(target,total,0,GL_STREAM_DRAW);
+			m_staging.resize(total);
+			m_mapped = &m_staging[0];
+		}
+
+		glBindBuffer(target,0);
+		m_frame = 0;
+		m_head = 0;
+		m_stalls = 0;
+		return true;
+	}
+
+	void destroy() {
+		for (uint32_t i = 0,j = m_fences.size();i < j;++i) {
+			if (m_fences[i])
+				glDeleteSync(m_fences[i]);
+		}
+
+		if (m_buffer != 0) {
+			if (m_persistent) {
+				glBindBuffer(m_target,m_buffer);
+				glUnmapBuffer(m_target);
+				glBindBuffer(m_target,0);
+			}
+			glDeleteBuffers(1,&m_buffer);
+		}
+
+		m_fences.clear();
+		m_staging.clear();
+		m_buffer = 0;
+		m_mapped = 0;
+		m_frame_size = 0;
+		m_head = 0;
+		m_persistent = false;
+	}
+
+	/*
+		Reserves size bytes in the current frame region.offset receives the buffer offset for bind(),
+		returns 0 when the region is full (create() with a bigger frame_size).
+	*/
+	inline uint8_t* alloc(const uint32_t size,uint32_t& offset) {
+		const uint32_t end = (m_frame + 1) * m_frame_size;
+		if ((size > m_frame_size) || (m_head > (end - size)))
+			return 0;
+
+		offset = m_head;
+		m_head = std::min(end,round_up(m_head + size,m_align));
+		return m_mapped + offset;
+	}
+
+	inline void bind(const GLuint binding,const uint32_t offset,const uint32_t size) const {
+		upload(offset,size);
+		glBindBufferRange(m_target,binding,m_buffer,offset,size);
+	}
+
+	/*
+		Makes alloc()ed bytes visible to GL without binding them to an indexed target (ie indirect commands).
+		Without persistent mapping the ring buffer is left bound to its target,as bind() leaves it.
+	*/
+	inline void upload(const uint32_t offset,const uint32_t size) const {
+		if (!m_persistent) {
+			glBindBuffer(m_target,m_buffer);
+			glBufferSubData(m_target,offset,size,m_mapped + offset);
+		}
+	}
+
+	//alloc() + memcpy + bind()
+	inline bool push(const GLuint binding,const void* data,const uint32_t size) {
+		uint32_t offset;
+		uint8_t* dst = alloc(size,offset);
+		if (!dst)
+			return false;
+
+		memcpy(dst,data,size);
+		bind(binding,offset,size);
+		return true;
+	}
+
+	//Fences the current region and moves to the next one,waiting for the GPU if it still reads from it
+	void end_frame() {
+		if (m_fences.empty())
+			return;
+
+		const uint32_t frames = m_fences.size();
+		if (m_persistent)
+			m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE,0);
+
+		m_frame = (m_frame + 1) % frames;
+		m_head = m_frame * m_frame_size;
+
+		GLsync fence = m_fences[m_frame];
+		if (!fence)
+			return;
+
+		GLenum res = glClientWaitSync(fence,GL_SYNC_FLUSH_COMMANDS_BIT,0);
+		if (res == GL_TIMEOUT_EXPIRED) {
+			++m_stalls;
+			do {
+				res = glClientWaitSync(fence,GL_SYNC_FLUSH_COMMANDS_BIT,1000000);	//1ms
+			} while (res == GL_TIMEOUT_EXPIRED);
+		}
+
+		glDeleteSync(fence);
+		m_fences[m_frame] = 0;
+	}
+
+	inline GLuint get_buffer() const {
+		return m_buffer;
+	}
+
+	inline uint32_t get_alignment() const {
+		return m_align;
+	}
+
+	//Bytes used in the current frame region
+	inline uint32_t get_used() const {
+		return m_head - m_frame * m_frame_size;
+	}
+
+	//end_frame() calls that had to wait for the GPU (frame_size too small or too few frames in flight)
+	inline uint32_t get_stalls() const {
+		return m_stalls;
+	}
+
+	inline bool is_persistent() const {
+		return m_persistent;
+	}
+};
+
+#endif